@@ -5,6 +5,11 @@
 
 #include <algorithm>
 #include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <cassert>
+#include <unordered_map>
+#include <unordered_set>
 
 //#include "timer.h"
 
@@ -123,47 +128,208 @@ public:
         Surface
 ------------------------*/
 
-// Converts the surface into a mesh
-ArrayMesh* Surface::getMesh(ArrayMesh* mesh /* = nullptr*/){
-    if (!mesh) mesh = ArrayMesh::_new();
+/*------------------------
+        SurfaceBuilder
+------------------------*/
 
-    Array arrays;
-    arrays.resize(Mesh::ArrayType::ARRAY_MAX);
-
-    if(verts.size() > 0)
-        arrays[Mesh::ArrayType::ARRAY_VERTEX] = verts;
-    if (norms.size() > 0)
-        arrays[Mesh::ArrayType::ARRAY_NORMAL] = norms;
-    if (uvs.size() > 0)
-        arrays[Mesh::ArrayType::ARRAY_TEX_UV] = uvs;
-    if (colors.size() > 0)
-        arrays[Mesh::ArrayType::ARRAY_COLOR] = colors;
-    if (indecies.size() > 0)
-        arrays[Mesh::ArrayType::ARRAY_INDEX] = indecies;
-
-    mesh->add_surface_from_arrays(Mesh::PrimitiveType::PRIMITIVE_TRIANGLES, arrays);
-    return mesh;
+// Function which reserves space for <faces> more quads
+void SurfaceBuilder::reserve(size_t faces){
+    verts.reserve(verts.size() + faces * 4);
+    norms.reserve(norms.size() + faces * 4);
+    uvs.reserve(uvs.size() + faces * 4);
+    indecies.reserve(indecies.size() + faces * 6);
+}
+
+// Function which adds a face to the surface
+void SurfaceBuilder::addFace(const Face& face){
+    int base = verts.size();
+    if (face.type == Face::Type::TRIANGLE){
+        verts.insert(verts.end(), {face.a.point, face.b.point, face.c.point});
+        norms.insert(norms.end(), 3, face.normal);
+        uvs.insert(uvs.end(), {face.a.uv, face.b.uv, face.c.uv});
+        indecies.insert(indecies.end(), {base, base + 1, base + 2});
+    } else if (face.type == Face::Type::QUAD){
+        verts.insert(verts.end(), {face.a.point, face.b.point, face.c.point, face.d.point});
+        norms.insert(norms.end(), 4, face.normal);
+        uvs.insert(uvs.end(), {face.a.uv, face.b.uv, face.c.uv, face.d.uv});
+        indecies.insert(indecies.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+    }
 }
 
 // Adds another surface to this one
-void Surface::append(Surface& other){
+void SurfaceBuilder::append(const SurfaceBuilder& other){
     int maxIndex = verts.size();
+    size_t triangles = indecies.size() / 3;
+    // Triangles without a material are drawn with material 0
+    if(materials.size() || other.materials.size()){
+        materials.resize(triangles, 0);
+        if(other.materials.size())
+            materials.insert(materials.end(), other.materials.begin(), other.materials.end());
+        else
+            materials.resize(triangles + other.indecies.size() / 3, 0);
+    }
 
-    for (Vector3& vert: other.verts)
-        verts.push_back(vert);
-    for (Vector3& normal: other.norms)
-        norms.push_back(normal);
-    for (Vector2& uv: other.uvs)
-        uvs.push_back(uv);
-    for (Color& color: other.colors)
-        colors.push_back(color);
+    verts.insert(verts.end(), other.verts.begin(), other.verts.end());
+    norms.insert(norms.end(), other.norms.begin(), other.norms.end());
+    uvs.insert(uvs.end(), other.uvs.begin(), other.uvs.end());
+    colors.insert(colors.end(), other.colors.begin(), other.colors.end());
+    indecies.reserve(indecies.size() + other.indecies.size());
     for (int index: other.indecies)
         indecies.push_back(index + maxIndex);
 }
 
-// Constructs a surface from a list of contiguous, coplanar, faces
-Surface Surface::GreedyMeshCoplanar(std::vector<Face> faces, Direction dir, Vector3 center){
-	const int CHUNK_DIMENSIONS = 16;
+// Function which merges vertices with the same position, normal, uv, and color, and points the indices at the merged vertices
+void SurfaceBuilder::weld(){
+    // Attributes which aren't provided for every vertex are left out of the comparison
+    bool hasNorms = norms.size() == verts.size(), hasUVs = uvs.size() == verts.size(), hasColors = colors.size() == verts.size();
+
+    // All of the attributes of a vertex packed together, vertices are only welded if they match bit for bit
+    struct Key {
+        float data[12];
+        bool operator==(const Key& o) const { return !memcmp(data, o.data, sizeof(data)); }
+    };
+    struct Hash {
+        size_t operator()(const Key& k) const {
+            uint32_t bits[12];
+            memcpy(bits, k.data, sizeof(bits));
+            uint64_t h = 14695981039346656037ull;
+            for(uint32_t b: bits)
+                h = (h ^ b) * 1099511628211ull;
+            return h;
+        }
+    };
+
+    std::unordered_map<Key, int, Hash> unique;
+    unique.reserve(verts.size());
+    // The new index of every old vertex
+    std::vector<int> remap(verts.size());
+    size_t count = 0;
+    for(size_t i = 0; i < verts.size(); i++){
+        // Adding 0 turns -0 into +0 so that they compare equal
+        Key key = {};
+        key.data[0] = verts[i].x + 0.f; key.data[1] = verts[i].y + 0.f; key.data[2] = verts[i].z + 0.f;
+        if(hasNorms){ key.data[3] = norms[i].x + 0.f; key.data[4] = norms[i].y + 0.f; key.data[5] = norms[i].z + 0.f; }
+        if(hasUVs){ key.data[6] = uvs[i].x + 0.f; key.data[7] = uvs[i].y + 0.f; }
+        if(hasColors){ key.data[8] = colors[i].r; key.data[9] = colors[i].g; key.data[10] = colors[i].b; key.data[11] = colors[i].a; }
+
+        auto found = unique.emplace(key, count);
+        // If this is the first time we have seen the vertex, compact it into the front of the arrays
+        if(found.second){
+            verts[count] = verts[i];
+            if(hasNorms) norms[count] = norms[i];
+            if(hasUVs) uvs[count] = uvs[i];
+            if(hasColors) colors[count] = colors[i];
+            count++;
+        }
+        remap[i] = found.first->second;
+    }
+
+    verts.resize(count);
+    if(hasNorms) norms.resize(count);
+    if(hasUVs) uvs.resize(count);
+    if(hasColors) colors.resize(count);
+    for(int& index: indecies)
+        index = remap[index];
+}
+
+// Function which moves every vertex by <offset>
+void SurfaceBuilder::translate(const Vector3& offset){
+    for(Vector3& v: verts)
+        v += offset;
+}
+
+// Function which draws every triangle from the <firstTriangle>th on with <material>
+void SurfaceBuilder::setMaterial(size_t firstTriangle, int material){
+    // Surfaces only drawn with material 0 don't need to track it
+    if(materials.empty() && material == 0) return;
+    materials.resize(indecies.size() / 3, 0);
+    std::fill(materials.begin() + firstTriangle, materials.end(), material);
+}
+
+/*------------------------
+        Surface
+------------------------*/
+
+// Function which copies a vector into a pool array (locking the pool array once instead of once per element)
+template<class Pool, class T>
+static Pool toPool(const std::vector<T>& in){
+    Pool out;
+    out.resize(in.size());
+    if(in.size()){
+        typename Pool::Write write = out.write();
+        memcpy(write.ptr(), in.data(), in.size() * sizeof(T));
+    }
+    return out;
+}
+
+// Converts the surface into a mesh
+ArrayMesh* Surface::getMesh(ArrayMesh* mesh /* = nullptr*/, int64_t compressFlags /* = Mesh::ARRAY_COMPRESS_DEFAULT*/,
+		Mesh::PrimitiveType primitive /* = Mesh::PRIMITIVE_TRIANGLES*/, const std::vector<Ref<Material>>* surfaceMaterials /* = nullptr*/){
+    if (!mesh) mesh = ArrayMesh::_new();
+
+    // Function which adds <surf> to the mesh as a surface drawn with <material>
+    auto addSurface = [mesh, compressFlags, primitive, surfaceMaterials](const SurfaceBuilder& surf, int material){
+        Array arrays;
+        arrays.resize(Mesh::ArrayType::ARRAY_MAX);
+
+        if(surf.verts.size() > 0)
+            arrays[Mesh::ArrayType::ARRAY_VERTEX] = toPool<PoolVector3Array>(surf.verts);
+        if (surf.norms.size() > 0)
+            arrays[Mesh::ArrayType::ARRAY_NORMAL] = toPool<PoolVector3Array>(surf.norms);
+        if (surf.uvs.size() > 0)
+            arrays[Mesh::ArrayType::ARRAY_TEX_UV] = toPool<PoolVector2Array>(surf.uvs);
+        if (surf.colors.size() > 0)
+            arrays[Mesh::ArrayType::ARRAY_COLOR] = toPool<PoolColorArray>(surf.colors);
+        if (surf.indecies.size() > 0)
+            arrays[Mesh::ArrayType::ARRAY_INDEX] = toPool<PoolIntArray>(surf.indecies);
+
+        mesh->add_surface_from_arrays(primitive, arrays, Array(), compressFlags);
+        if(surfaceMaterials && material < (int) surfaceMaterials->size() && (*surfaceMaterials)[material].is_valid())
+            mesh->surface_set_material(mesh->get_surface_count() - 1, (*surfaceMaterials)[material]);
+    };
+
+    // Triangles added after the last material was set are drawn with material 0
+    std::vector<int> triangleMaterials = materials;
+    if(!triangleMaterials.empty())
+        triangleMaterials.resize(indecies.size() / 3, 0);
+
+    // A surface drawn with a single material is uploaded as it is
+    std::vector<int> used = triangleMaterials;
+    std::sort(used.begin(), used.end());
+    used.erase(std::unique(used.begin(), used.end()), used.end());
+    if(used.size() <= 1){
+        addSurface(*this, used.empty() ? 0 : used[0]);
+        return mesh;
+    }
+
+    // Otherwise each material gets a surface with its triangles and the vertices they use
+    bool hasNorms = norms.size() == verts.size(), hasUVs = uvs.size() == verts.size(), hasColors = colors.size() == verts.size();
+    std::vector<int> remap(verts.size());
+    for(int material: used){
+        SurfaceBuilder part;
+        std::fill(remap.begin(), remap.end(), -1);
+        for(size_t t = 0; t < triangleMaterials.size(); t++){
+            if(triangleMaterials[t] != material) continue;
+            for(int k = 0; k < 3; k++){
+                int vertex = indecies[t * 3 + k];
+                if(remap[vertex] < 0){
+                    remap[vertex] = part.verts.size();
+                    part.verts.push_back(verts[vertex]);
+                    if(hasNorms) part.norms.push_back(norms[vertex]);
+                    if(hasUVs) part.uvs.push_back(uvs[vertex]);
+                    if(hasColors) part.colors.push_back(colors[vertex]);
+                }
+                part.indecies.push_back(remap[vertex]);
+            }
+        }
+        addSurface(part, material);
+    }
+    return mesh;
+}
+
+// Constructs a surface from a list of contiguous, coplanar, faces lying in a square layer <size> cells across centered on <center>,
+// each cell is <scale> units wide (so coarser levels of detail can be meshed on a smaller mask)
+Surface Surface::GreedyMeshCoplanar(std::vector<Face> faces, Direction dir, Vector3 center, int size, float scale){
 	struct Quad { float x, y, w, h; int blockID, i = -1; };
 
 	// Surface storing the optimized layer
@@ -184,7 +350,7 @@ Surface Surface::GreedyMeshCoplanar(std::vector<Face> faces, Direction dir, Vect
 			maskQuads.push_back(q);\
 		/* Triangular faces are passed straight out without being optimized */\
 		} else\
-			out += f.getSurface();
+			out += f;
 	switch(dir){
 	case TOP:
 	case BOTTOM: reduce(x, z); break;
@@ -196,93 +362,49 @@ Surface Surface::GreedyMeshCoplanar(std::vector<Face> faces, Direction dir, Vect
 
 	// If there are any faces to be optimized
 	if(maskQuads.size()){
-		// Function which determines if a point is inside a quad
-		auto withinQuad = [](const Quad& q, float x, float y){
-			if(x >= q.x && x < q.x + q.w
-			  && y >= q.y && y < q.y + q.h)
-				return true;
-			return false;
+		// Function which converts a distance from the center of the layer into a cell index
+		float half = size * scale / 2;
+		auto toCell = [half, scale, size](float d){
+			int cell = (int) std::lround((d + half) / scale);
+			// A face hanging off the layer means the faces were sorted into the wrong layer, clamping would silently cut it off
+			assert(cell >= 0 && cell <= size);
+			// (still clamped so builds without asserts don't write outside of the mask)
+			return std::min(std::max(cell, 0), size);
 		};
 
-		// Compute the mask
-		int mask[CHUNK_DIMENSIONS * CHUNK_DIMENSIONS];
-		bool found;
-		for(int x = 0; x < CHUNK_DIMENSIONS; x++){
-			for(int y = 0; y < CHUNK_DIMENSIONS; y++){
-				found = false;
-				for(Quad& q: maskQuads)
-					if(withinQuad(q, x - 8, y - 8)){
-						mask[x * CHUNK_DIMENSIONS + y] = q.blockID;
-						found = true;
-						break;
-					}
-				if(!found)
-					mask[x * CHUNK_DIMENSIONS + y] = -1;
-			}
-		}
+		// Compute the mask by drawing each quad into it (where quads overlap the first one wins)
+		std::vector<int> mask(size * size, -1);
+		for(Quad& q: maskQuads)
+			for(int x = toCell(q.x); x < toCell(q.x + q.w); x++)
+				for(int y = toCell(q.y); y < toCell(q.y + q.h); y++)
+					if(mask[x * size + y] == -1)
+						mask[x * size + y] = q.blockID;
 
 		// Generate Mesh
 		// Code from: https://github.com/roboleary/GreedyMesh/blob/master/src/mygame/Main.java
 		int n = 0, w, h;
-		// TODO:? potentialy do this 4 times coming from each corner and use the mesh with the least number of faces
-	    for(int y = 0; y < CHUNK_DIMENSIONS; y++) {
-	        for(int x = 0; x < CHUNK_DIMENSIONS;) {
+		// Always sweeps from the same corner (BinaryMesher::bestOrientationSlice sweeps from every corner and keeps the fewest faces)
+	    for(int y = 0; y < size; y++) {
+	        for(int x = 0; x < size;) {
 	            if(mask[n] != -1) {
 					// We compute the width
-	                for(w = 1; x + w < CHUNK_DIMENSIONS && mask[n + w] != -1 && mask[n + w] == mask[n]; w++) {}
+	                for(w = 1; x + w < size && mask[n + w] != -1 && mask[n + w] == mask[n]; w++) {}
 
 	                // Then we compute height
 	                bool done = false;
-	                for(h = 1; y + h < CHUNK_DIMENSIONS; h++) {
+	                for(h = 1; y + h < size; h++) {
 	                    for(int k = 0; k < w; k++)
-	                        if(mask[n + k + h * CHUNK_DIMENSIONS] == -1 || mask[n + k + h * CHUNK_DIMENSIONS] != mask[n]) { done = true; break; }
+	                        if(mask[n + k + h * size] == -1 || mask[n + k + h * size] != mask[n]) { done = true; break; }
 	                    if(done) break;
 	                }
 
 					// Compute face
-					switch(dir){
-					case TOP:
-						out += Face(Vector3(y - 8, 0, x - 8) + center,
-								Vector3(y - 8 + h, 0, x - 8) + center,
-								Vector3(y - 8 + h, 0, x - 8 + w) + center,
-								Vector3(y - 8, 0, x - 8 + w) + center, mask[n]).getSurface();
-						break;
-					case BOTTOM:
-						out += Face(Vector3(y - 8, 0, x - 8) + center,
-								Vector3(y - 8 + h, 0, x - 8) + center,
-								Vector3(y - 8 + h, 0, x - 8 + w) + center,
-								Vector3(y - 8, 0, x - 8 + w) + center, mask[n]).reverse().getSurface();
-						break;
-					case NORTH:
-						out += Face(Vector3(0, y - 8,  x - 8) + center,
-								Vector3(0, y - 8 + h,  x - 8) + center,
-								Vector3(0, y - 8 + h,  x - 8 + w) + center,
-								Vector3(0, y - 8,  x - 8 + w) + center, mask[n]).reverse().getSurface();
-						break;
-					case SOUTH:
-						out += Face(Vector3(0, y - 8,  x - 8) + center,
-								Vector3(0, y - 8 + h,  x - 8) + center,
-								Vector3(0, y - 8 + h,  x - 8 + w) + center,
-								Vector3(0, y - 8,  x - 8 + w) + center, mask[n]).getSurface();
-						break;
-					case EAST:
-						out += Face(Vector3(y - 8,  x - 8, 0) + center,
-								Vector3(y - 8 + h,  x - 8, 0) + center,
-								Vector3(y - 8 + h,  x - 8 + w, 0) + center,
-								Vector3(y - 8,  x - 8 + w, 0) + center, mask[n]).reverse().getSurface();
-						break;
-					case WEST:
-						out += Face(Vector3(y - 8,  x - 8, 0) + center,
-								Vector3(y - 8 + h,  x - 8, 0) + center,
-								Vector3(y - 8 + h,  x - 8 + w, 0) + center,
-								Vector3(y - 8,  x - 8 + w, 0) + center, mask[n]).getSurface();
-						break;
-					}
+					out += greedyQuad(dir, center, y, x, h, w, mask[n], size, scale);
 
 	                // We zero out the mask
 	                for(int l = 0; l < h; ++l)
 	                    for(int k = 0; k < w; ++k)
-							mask[n + k + l * CHUNK_DIMENSIONS] = -1;
+							mask[n + k + l * size] = -1;
 
 	                // And then finally increment the counters and continue
 	                x += w;
@@ -299,24 +421,102 @@ Surface Surface::GreedyMeshCoplanar(std::vector<Face> faces, Direction dir, Vect
 	return out;
 }
 
-// Converts the surface into a wireframe representation
-Spatial* Surface::getWireframe(){
-	Spatial* out = Spatial::_new();
-	out->set_name("Wireframe");
-	for(int i = 0; i < indecies.size(); i += 3){
-		SurfaceTool* line = SurfaceTool::_new();
-		Vector3 normal = norms[indecies[i]].normalized() / 10000;
-		line->begin(Mesh::PRIMITIVE_LINES);
-		line->add_vertex(verts.read()[indecies.read()[i]] + normal);
-		line->add_vertex(verts.read()[indecies.read()[i + 1]] + normal);
-		line->add_vertex(verts.read()[indecies.read()[i + 1]] + normal);
-		line->add_vertex(verts.read()[indecies.read()[i + 2]] + normal);
-		line->add_vertex(verts.read()[indecies.read()[i + 2]] + normal);
-		line->add_vertex(verts.read()[indecies.read()[i]] + normal);
-		MeshInstance* instance = MeshInstance::_new();
-		instance->set_mesh(line->commit());
-		out->add_child(instance);
+// Function which builds the face covering <h> cells along the first axis and <w> cells along the second axis of a layer,
+// starting at cell (<first>, <second>) (see GreedyMeshCoplanar for which axes are first and second in each direction),
+// the layer is <size> cells across centered on <center> and each cell is <scale> units wide
+Face Surface::greedyQuad(Direction dir, Vector3 center, int first, int second, int h, int w, int blockID, int size, float scale){
+	// Offsets of the quad's edges from the center of the layer
+	float half = size * scale / 2;
+	float y = first * scale - half, x = second * scale - half, y2 = (first + h) * scale - half, x2 = (second + w) * scale - half;
+	// Function which builds the corner of the quad at <offset> from the center of the layer, which is <f> along the first axis and <s> along the second
+	auto corner = [dir, center, half, size, scale](Vector3 offset, float f, float s){
+		return Vertex(offset + center, layerUV(dir, f + half, s + half, size * scale));
+	};
+	switch(dir){
+	case TOP:
+		return Face(corner(Vector3(y, 0, x), y, x),
+				corner(Vector3(y2, 0, x), y2, x),
+				corner(Vector3(y2, 0, x2), y2, x2),
+				corner(Vector3(y, 0, x2), y, x2), blockID);
+	case BOTTOM:
+		return Face(corner(Vector3(y, 0, x), y, x),
+				corner(Vector3(y2, 0, x), y2, x),
+				corner(Vector3(y2, 0, x2), y2, x2),
+				corner(Vector3(y, 0, x2), y, x2), blockID).reverse();
+	case NORTH:
+		return Face(corner(Vector3(0, y,  x), y, x),
+				corner(Vector3(0, y2,  x), y2, x),
+				corner(Vector3(0, y2,  x2), y2, x2),
+				corner(Vector3(0, y,  x2), y, x2), blockID).reverse();
+	case SOUTH:
+		return Face(corner(Vector3(0, y,  x), y, x),
+				corner(Vector3(0, y2,  x), y2, x),
+				corner(Vector3(0, y2,  x2), y2, x2),
+				corner(Vector3(0, y,  x2), y, x2), blockID);
+	case EAST:
+		return Face(corner(Vector3(y,  x, 0), y, x),
+				corner(Vector3(y2,  x, 0), y2, x),
+				corner(Vector3(y2,  x2, 0), y2, x2),
+				corner(Vector3(y,  x2, 0), y, x2), blockID).reverse();
+	case WEST:
+		return Face(corner(Vector3(y,  x, 0), y, x),
+				corner(Vector3(y2,  x, 0), y2, x),
+				corner(Vector3(y2,  x2, 0), y2, x2),
+				corner(Vector3(y,  x2, 0), y, x2), blockID);
+	}
+	return Face(Vector3(), Vector3(), Vector3());
+}
+
+// Function which gets the texture coordinates of the point <first> units along the first axis and <second> units along the second axis
+// of a layer facing <dir> (measured from the layer's corner) which is <extent> units across
+Vector2 Surface::layerUV(Direction dir, float first, float second, float extent){
+	// The first and second axes are (x, z) on the top and bottom, (y, z) facing north and south, and (x, y) facing east and west,
+	// u runs to the right and v runs down when looking at the face from outside
+	switch(dir){
+	case NORTH: return Vector2(extent - second, extent - first);
+	case SOUTH: return Vector2(second, extent - first);
+	case EAST: return Vector2(first, extent - second);
+	case WEST: return Vector2(extent - first, extent - second);
+	default: return Vector2(first, second);
 	}
+}
+
+// Function which outlines every triangle of the surface, the indices of the result come in pairs (one line each, meant to be
+// drawn with PRIMITIVE_LINES) and an edge shared by several triangles is only added once
+Surface Surface::getWireframe() const {
+	// Weld the positions alone so that triangles which share an edge also share its indices
+	Surface out;
+	out.verts = verts;
+	out.indecies = indecies;
+	out.weld();
+	std::vector<int> triangles;
+	triangles.swap(out.indecies);
+
+	// Edges which have already been added, keyed by their (smaller, larger) pair of indices
+	std::unordered_set<uint64_t> edges;
+	edges.reserve(triangles.size());
+	out.indecies.reserve(triangles.size());
+	for(size_t i = 0; i + 2 < triangles.size(); i += 3)
+		for(int e = 0; e < 3; e++){
+			uint32_t a = triangles[i + e], b = triangles[i + (e + 1) % 3];
+			if(a > b) std::swap(a, b);
+			if(edges.insert(uint64_t(a) << 32 | b).second){
+				out.indecies.push_back(a);
+				out.indecies.push_back(b);
+			}
+		}
+
+	// Lift every vertex slightly off the surface (along the normals of the triangles around it) so the lines don't z-fight with it
+	std::vector<Vector3> offsets(out.verts.size(), Vector3());
+	for(size_t i = 0; i + 2 < triangles.size(); i += 3){
+		const Vector3 &a = out.verts[triangles[i]], &b = out.verts[triangles[i + 1]], &c = out.verts[triangles[i + 2]];
+		Vector3 normal = (c - a).cross(b - a);
+		for(int k = 0; k < 3; k++)
+			offsets[triangles[i + k]] += normal;
+	}
+	for(size_t v = 0; v < out.verts.size(); v++)
+		if(offsets[v].length() > 0)
+			out.verts[v] += offsets[v].normalized() / 10000;
 	return out;
 }
 
@@ -358,33 +558,7 @@ bool Face::checkContiguiousCoplanar(Face& other){
 // Constructs a surface from this face
 Surface Face::getSurface(){
     Surface surf;
-    if (type == Face::Type::TRIANGLE){
-        surf.verts.push_back(a);
-        surf.norms.push_back(normal);
-        surf.indecies.push_back(0);
-        surf.verts.push_back(b);
-        surf.norms.push_back(normal);
-        surf.indecies.push_back(1);
-        surf.verts.push_back(c);
-        surf.norms.push_back(normal);
-        surf.indecies.push_back(2);
-    } else if (type == Face::Type::QUAD){
-        surf.verts.push_back(a);
-        surf.norms.push_back(normal);
-        surf.verts.push_back(b);
-        surf.norms.push_back(normal);
-        surf.verts.push_back(c);
-        surf.norms.push_back(normal);
-        surf.verts.push_back(d);
-        surf.norms.push_back(normal);
-
-        surf.indecies.push_back(0);
-        surf.indecies.push_back(1);
-        surf.indecies.push_back(2);
-        surf.indecies.push_back(2);
-        surf.indecies.push_back(3);
-        surf.indecies.push_back(0);
-    }
+    surf.addFace(*this);
     return surf;
 }
 
@@ -2,27 +2,19 @@
 #define _SURF_FACE_EDGE_H_
 #include <ArrayMesh.hpp>
 #include <MeshInstance.hpp>
+#include <Material.hpp>
 
 #include <vector>
 
 #include "godot/Gstream.hpp"
 
 enum Direction {NORTH, SOUTH, EAST, WEST, TOP, BOTTOM};
-
-// Add ranged based for loop support to PoolVector3Array and PoolIntArray
-namespace godot{
-	#define __RANGED_BASED_FOR__(x) inline auto begin(godot::x& what){\
-		return what.write().ptr();\
-	}\
-	inline auto end(godot::x& what){\
-		return &what.write()[what.size()];\
-	}
-
-	__RANGED_BASED_FOR__(PoolVector3Array)
-	__RANGED_BASED_FOR__(PoolVector2Array)
-	__RANGED_BASED_FOR__(PoolColorArray)
-	__RANGED_BASED_FOR__(PoolIntArray)
-};
+// Function which gets the axis a direction points along (0 = x, 1 = y, 2 = z)
+inline int axisOf(Direction d){ return d == NORTH || d == SOUTH ? 0 : d == TOP || d == BOTTOM ? 1 : 2; }
+// Function which determines if a direction points towards the positive end of its axis
+inline bool isPositive(Direction d){ return d == NORTH || d == EAST || d == TOP; }
+// Function which gets the direction pointing the other way
+inline Direction opposite(Direction d){ return Direction(d ^ 1); }
 
 using namespace godot;
 
@@ -45,31 +37,70 @@ struct Vertex {
 	}
 };
 
-class Surface{
+/*
+	Accumulates the geometry of a surface in std::vectors (one per attribute) so
+	that faces can be added without locking or reallocating Godot's pool arrays
+	for every element. The data is only converted into pool arrays, with a single
+	copy per attribute, once the mesh is built.
+*/
+class SurfaceBuilder {
 public:
 	// Positions
-	PoolVector3Array verts;
-  	// Normals
-	PoolVector3Array norms;
+	std::vector<Vector3> verts;
+	// Normals
+	std::vector<Vector3> norms;
 	// UVs
-	PoolVector2Array uvs;
+	std::vector<Vector2> uvs;
 	// Color
-	PoolColorArray colors;
+	std::vector<Color> colors;
 	// Indecies
-	PoolIntArray indecies;
-
+	std::vector<int> indecies;
+	// Material of each triangle (empty if every triangle is drawn with material 0)
+	std::vector<int> materials;
+
+	// Function which reserves space for <faces> more quads
+	void reserve(size_t faces);
+	// Function which adds a face to the surface
+	void addFace(const Face& face);
 	// Adds another surface to this one
-	void append(Surface& other);
-	void append(Surface&& other){ append(other); }
-	Surface& operator +=(Surface& other){ this->append(other); return *this; }
-	Surface& operator +=(Surface&& other) {return *this += other; }
-
-	// Constructs a surface from a list of contiguous, coplanar, faces
-	static Surface GreedyMeshCoplanar(std::vector<Face> faces, Direction dir, Vector3 center);
-	// Converts the surface into a mesh
-	ArrayMesh* getMesh(ArrayMesh* mesh = nullptr);
-	// Converts the surface into a wireframe representation
-	Spatial* getWireframe();
+	void append(const SurfaceBuilder& other);
+	// Function which merges vertices with the same position, normal, uv, and color, and points the indices at the merged vertices
+	void weld();
+	// Function which moves every vertex by <offset>
+	void translate(const Vector3& offset);
+	// Function which draws every triangle from the <firstTriangle>th on with <material>
+	void setMaterial(size_t firstTriangle, int material);
+};
+
+class Surface: public SurfaceBuilder {
+public:
+	Surface& operator +=(const SurfaceBuilder& other){ this->append(other); return *this; }
+	Surface& operator +=(const Face& face){ this->addFace(face); return *this; }
+
+	// Constructs a surface from a list of contiguous, coplanar, faces lying in a square layer <size> cells across centered on <center>,
+	// each cell is <scale> units wide (so coarser levels of detail can be meshed on a smaller mask)
+	static Surface GreedyMeshCoplanar(std::vector<Face> faces, Direction dir, Vector3 center, int size, float scale = 1);
+	// Function which builds the face covering <h> cells along the first axis and <w> cells along the second axis of a layer,
+	// starting at cell (<first>, <second>) (see GreedyMeshCoplanar for which axes are first and second in each direction),
+	// the layer is <size> cells across centered on <center> and each cell is <scale> units wide
+	static Face greedyQuad(Direction dir, Vector3 center, int first, int second, int h, int w, int blockID, int size, float scale = 1);
+	// Function which gets the texture coordinates of the point <first> units along the first axis and <second> units along the second axis
+	// of a layer facing <dir> (measured from the layer's corner) which is <extent> units across, textures repeat every unit so merged
+	// faces tile them instead of stretching them, and the sides of blocks are upright when looked at from outside
+	static Vector2 layerUV(Direction dir, float first, float second, float extent);
+	// Compression flags for surfaces whose positions are small integers and whose normals are axis aligned (such as chunk local blocky meshes),
+	// positions are stored as 16 bit half floats, normals, uvs, and colors as bytes, and indices as 16 bit integers
+	static const int64_t COMPACT_FORMAT = Mesh::ARRAY_COMPRESS_VERTEX | Mesh::ARRAY_COMPRESS_NORMAL | Mesh::ARRAY_COMPRESS_TEX_UV
+		| Mesh::ARRAY_COMPRESS_COLOR | Mesh::ARRAY_COMPRESS_INDEX;
+
+	// Converts the surface into a mesh (<compressFlags> are Godot's Mesh::ARRAY_COMPRESS_* flags, <primitive> is how the indices are connected),
+	// the mesh gets a surface (and a draw call) per material the triangles use, in increasing order, drawn with <surfaceMaterials>[material] if provided
+	ArrayMesh* getMesh(ArrayMesh* mesh = nullptr, int64_t compressFlags = Mesh::ARRAY_COMPRESS_DEFAULT, Mesh::PrimitiveType primitive = Mesh::PRIMITIVE_TRIANGLES,
+		const std::vector<Ref<Material>>* surfaceMaterials = nullptr);
+	// Function which outlines every triangle of the surface, the indices of the result come in pairs (one line each, meant to be
+	// drawn with PRIMITIVE_LINES) and an edge shared by several triangles is only added once, the lines are lifted slightly off
+	// the surface so they don't z-fight with it
+	Surface getWireframe() const;
 };
 
 class Face{
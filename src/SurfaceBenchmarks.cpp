@@ -0,0 +1,466 @@
+#include "SurfaceBenchmarks.h"
+
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <cmath>
+
+#include "timer.h"
+#include "godot/Gstream.hpp"
+#include "block/BlockDatabase.h"
+#include "mesh/BinaryMesher.h"
+#include "mesh/Mesher.h"
+#include "world/PalettedStorage.h"
+
+// Names of the chunk storage backends (indexed by Chunk::Storage)
+static const char* storageNames[] = {"octree", "paletted", "linear octree"};
+
+// Function which lists the quads (4 vertices each) in a surface sorted so that two surfaces can be compared regardless of order
+static std::vector<std::string> quadKeys(const Surface& surf){
+	std::vector<std::string> out;
+	for(size_t i = 0; i + 3 < surf.verts.size(); i += 4){
+		std::string key;
+		for(int j = 0; j < 4; j++)
+			key += std::string(String(surf.verts[i + j]).utf8().get_data()) + ";";
+		out.push_back(key);
+	}
+	std::sort(out.begin(), out.end());
+	return out;
+}
+
+// Function which lists the triangles in a surface sorted so that two surfaces can be compared regardless of order or indexing
+// (each triangle starts from its smallest vertex so that its winding is kept)
+static std::vector<std::string> triangleKeys(const Surface& surf){
+	std::vector<std::string> out;
+	for(size_t i = 0; i + 2 < surf.indecies.size(); i += 3){
+		std::string corners[3];
+		for(int j = 0; j < 3; j++)
+			corners[j] = String(surf.verts[surf.indecies[i + j]]).utf8().get_data();
+		int first = std::min_element(corners, corners + 3) - corners;
+		out.push_back(corners[first] + ";" + corners[(first + 1) % 3] + ";" + corners[(first + 2) % 3]);
+	}
+	std::sort(out.begin(), out.end());
+	return out;
+}
+
+// Function which runs every check and benchmark, returns the number of checks which failed
+int SurfaceBenchmarks::runAll(){
+	failures = 0;
+	checkVisibility();
+	checkGreedyMeshing();
+	checkLayerMeshes();
+	checkWelding();
+	checkPalettedStorage();
+	checkMaterials();
+
+	benchmarkGeneration();
+	benchmarkStorage();
+	benchmarkFaceCollection();
+	benchmarkLevelsOfDetail();
+	benchmarkLayerSizes();
+	benchmarkWorkers();
+	benchmarkMeshers();
+
+	gout << failures << " checks failed" << endl;
+	return failures;
+}
+
+// Function which gets the map, loading the chunk at the origin if it isn't loaded yet
+ChunkMap* SurfaceBenchmarks::getMap(){
+	if(!map){
+		map = ChunkMap::_new();
+		add_child(map);
+	}
+	// The map only loads its chunks once it enters the tree
+	if(!map->getChunk(ivec3(0, 0, 0)))
+		map->load(Vector3());
+	return map;
+}
+
+// Function which reports <what> as an error if the check didn't pass, returns <passed>
+bool SurfaceBenchmarks::check(bool passed, const char* what){
+	if(!passed){
+		failures++;
+		Godot::print_error(String("Check failed: ") + what, "SurfaceBenchmarks::check", __FILE__, __LINE__);
+	}
+	return passed;
+}
+
+// Function which checks that the neighbor traversal visibility matches looking up every neighbor from the root of its chunk
+// (on the loaded chunk, since the lookups can only find chunks which are in the map)
+bool SurfaceBenchmarks::checkVisibility(){
+	Chunk* c = getChunk();
+	std::vector<flag_t> expected;
+	gout << "visibility using lookups:" << endl;
+	{
+		Timer t;
+		for(int i = 0; i < 100; i++)
+			c->recalculateByLookup();
+	}
+	c->iterate(BLOCK_LEVEL, [&expected](VoxelInstance* v, int){ expected.push_back(v->flags); });
+	gout << "visibility using neighbor traversal:" << endl;
+	{
+		Timer t;
+		for(int i = 0; i < 100; i++)
+			c->recalculate();
+	}
+	int mismatches = 0;
+	c->iterate(BLOCK_LEVEL, [&expected, &mismatches](VoxelInstance* v, int i){ mismatches += v->flags != expected[i]; });
+	gout << "\t" << mismatches << " of " << expected.size() << " voxels disagree" << endl;
+	return check(mismatches == 0, "the neighbor traversal visibility differs from the lookup visibility");
+}
+
+// Function which checks that the bitmask greedy mesher builds the same quads as greedily meshing the faces layer by layer
+// (at full detail the bitmasks cull faces block by block, so they also drop the hidden faces of pruned voxels beside mixed voxels,
+// the two are only expected to match once every voxel is at least as large as a block)
+bool SurfaceBenchmarks::checkGreedyMeshing(){
+	Chunk* c = getChunk();
+	bool passed = true;
+	for(int levelOfDetail = 0; levelOfDetail < 2; levelOfDetail++){
+		gout << "level of detail " << levelOfDetail << ", greedy meshing by layers:" << endl;
+		Surface reference, binary;
+		{
+			Timer t;
+			for(int i = 0; i < 10; i++)
+				reference = c->buildCoplanarSurface(levelOfDetail);
+		}
+		gout << "level of detail " << levelOfDetail << ", greedy meshing with bitmasks:" << endl;
+		{
+			Timer t;
+			for(int i = 0; i < 10; i++){
+				VoxelGrid grid;
+				grid.capture(*c, levelOfDetail);
+				binary = BinaryMesher::mesh(grid);
+			}
+		}
+		std::vector<std::string> expectedQuads = quadKeys(reference), quads = quadKeys(binary);
+		gout << "\t" << quads.size() << " quads vs " << expectedQuads.size() << endl;
+		if(levelOfDetail > 0)
+			passed &= check(quads == expectedQuads, "the bitmask greedy mesher built different quads than meshing by layers");
+		else
+			passed &= check(quads.size() <= expectedQuads.size(), "the bitmask greedy mesher built more quads than meshing by layers");
+	}
+	return passed;
+}
+
+// Function which checks that remeshing a single layer builds the same surface as that layer of the whole chunk's mesh
+bool SurfaceBenchmarks::checkLayerMeshes(){
+	Chunk* c = getChunk();
+	VoxelGrid grid;
+	grid.capture(*c);
+	bool passed = true;
+	for(const Mesher* mesher: {Mesher::get(Mesher::BLOCKY), Mesher::get(Mesher::BLOCKY)->thorough(), Mesher::get(Mesher::POLYGON)}){
+		std::unique_ptr<Chunk::LayerSurfaces> layers(new Chunk::LayerSurfaces);
+		if(!mesher->meshLayers(grid, *layers)) continue;
+		int mismatches = 0;
+		for(int d = NORTH; d <= BOTTOM; d++)
+			for(int layer = 0; layer < CHUNK_DIMENSIONS; layer++){
+				VoxelGrid slice;
+				slice.captureLayer(*c, (Direction) d, layer);
+				Surface remeshed;
+				mesher->meshLayer(slice, (Direction) d, layer, remeshed);
+				mismatches += triangleKeys(remeshed) != triangleKeys((*layers)[d][layer]);
+			}
+		gout << "remeshing single layers with the " << mesher->getName() << " mesher: " << mismatches << " layers differ" << endl;
+		passed &= check(mismatches == 0, "remeshing a single layer built a different surface than meshing the whole chunk");
+	}
+	return passed;
+}
+
+// Function which checks that welding the chunk's plain and greedy meshes keeps every triangle
+bool SurfaceBenchmarks::checkWelding(){
+	Chunk* c = getChunk();
+	bool passed = true;
+	for(int greedy = 0; greedy < 2; greedy++){
+		Surface surf;
+		if(greedy){
+			VoxelGrid grid;
+			grid.capture(*c);
+			surf = BinaryMesher::mesh(grid);
+		} else {
+			std::vector<Face> faces;
+			c->iterate(BLOCK_LEVEL, [&faces](VoxelInstance* v, int){ v->getFaces(faces); });
+			surf.reserve(faces.size());
+			for(Face& f: faces)
+				surf += f;
+		}
+		size_t before = surf.verts.size();
+		std::vector<std::string> triangles = triangleKeys(surf);
+		gout << "welding the " << (greedy ? "greedy" : "plain") << " mesh:" << endl;
+		{
+			Timer t;
+			surf.weld();
+		}
+		gout << "\t" << before << " vertices -> " << surf.verts.size() << " vertices" << endl;
+		passed &= check(triangleKeys(surf) == triangles, "welding changed the triangles of the mesh");
+	}
+	return passed;
+}
+
+// Function which checks that a paletted chunk reads back every state written to it while its palette grows and is compacted
+// (the states are only stored, so they don't need to be in the block database)
+bool SurfaceBenchmarks::checkPalettedStorage(){
+	// Load the map if this is the first benchmark run
+	getMap();
+	// Seven states need the palette to grow from 1 to 2 to 4 bits per voxel
+	auto state = [](int x, int y, int z){ return BlockState((x + y * 3 + z * 5) % 7); };
+	map->storage = Chunk::PALETTED;
+	Chunk* paletted = map->generateChunk(Vector3(CHUNK_DIMENSIONS * 4, 0, 0));
+	map->storage = Chunk::OCTREE;
+	for(int x = 0; x < CHUNK_DIMENSIONS; x++)
+		for(int y = 0; y < CHUNK_DIMENSIONS; y++)
+			for(int z = 0; z < CHUNK_DIMENSIONS; z++)
+				paletted->setBlockState(x, y, z, state(x, y, z));
+	int mismatches = 0;
+	for(int x = 0; x < CHUNK_DIMENSIONS; x++)
+		for(int y = 0; y < CHUNK_DIMENSIONS; y++)
+			for(int z = 0; z < CHUNK_DIMENSIONS; z++)
+				mismatches += paletted->getBlockState(x, y, z) != state(x, y, z);
+	paletted->free();
+
+	// Compacting rebuilds the palette by setting every voxel again
+	PalettedStorage storage(CHUNK_ARRAY_SIZE);
+	for(size_t i = 0; i < storage.size(); i++)
+		storage.set(i, i % 7);
+	for(size_t i = 0; i < storage.size(); i += 2)
+		storage.set(i, 0);
+	storage.compact();
+	for(size_t i = 0; i < storage.size(); i++)
+		mismatches += storage.get(i) != (i % 2 ? i % 7 : 0);
+
+	gout << "paletted storage: " << mismatches << " voxels read back a different state" << endl;
+	return check(mismatches == 0, "the paletted storage read back a different state than was written");
+}
+
+// Function which checks that a chunk drawn with two materials is split into two surfaces which keep every triangle and tile their textures
+// (every texture coordinate should be a whole number, and each triangle should cover as much of the texture as it covers of the world)
+bool SurfaceBenchmarks::checkMaterials(){
+	// Load the map if this is the first benchmark run
+	getMap();
+	BlockDatabase* db = BlockDatabase::getSingleton();
+	// Block drawn with material 1 (only added to the database once)
+	static Identifier painted = db->addBlock(new BlockData(BlockData::null, {}, 1));
+
+	// Paint the solid blocks in one half of a chunk
+	Chunk* c = map->generateChunk(Vector3(CHUNK_DIMENSIONS * 4, 0, 0));
+	for(int x = 0; x < CHUNK_DIMENSIONS / 2; x++)
+		for(int y = 0; y < CHUNK_DIMENSIONS; y++)
+			for(int z = 0; z < CHUNK_DIMENSIONS; z++)
+				if(db->getState(c->getBlockState(x, y, z))->blockID != Blocks::AIR)
+					c->setBlock(x, y, z, painted);
+	VoxelGrid grid;
+	grid.capture(*c);
+	c->free();
+
+	bool passed = true;
+	for(const Mesher* mesher: {Mesher::get(Mesher::BLOCKY), Mesher::get(Mesher::POLYGON)}){
+		Surface surf = mesher->mesh(grid);
+		surf.weld();
+		int badUVs = 0;
+		for(size_t i = 0; i + 2 < surf.indecies.size(); i += 3){
+			Vector3 a = surf.verts[surf.indecies[i]], b = surf.verts[surf.indecies[i + 1]], d = surf.verts[surf.indecies[i + 2]];
+			Vector2 ua = surf.uvs[surf.indecies[i]], ub = surf.uvs[surf.indecies[i + 1]], ud = surf.uvs[surf.indecies[i + 2]];
+			float area = (b - a).cross(d - a).length();
+			float uvArea = std::abs((ub.x - ua.x) * (ud.y - ua.y) - (ub.y - ua.y) * (ud.x - ua.x));
+			badUVs += std::abs(area - uvArea) > 1e-4;
+			for(Vector2 uv: {ua, ub, ud})
+				badUVs += uv.x != std::floor(uv.x) || uv.y != std::floor(uv.y)
+					|| uv.x < 0 || uv.y < 0 || uv.x > CHUNK_DIMENSIONS || uv.y > CHUNK_DIMENSIONS;
+		}
+
+		Ref<ArrayMesh> mesh = surf.getMesh(nullptr, Surface::COMPACT_FORMAT);
+		size_t indices = 0;
+		for(int i = 0; i < mesh->get_surface_count(); i++)
+			indices += mesh->surface_get_array_index_len(i);
+		gout << "two materials with the " << mesher->getName() << " mesher: " << mesh->get_surface_count() << " surfaces, "
+			<< indices / 3 << " of " << surf.indecies.size() / 3 << " triangles, " << badUVs << " texture coordinates which don't tile" << endl;
+		passed &= check(mesh->get_surface_count() == 2, "a chunk drawn with two materials wasn't split into two surfaces");
+		passed &= check(indices == surf.indecies.size(), "splitting a mesh by material lost triangles");
+		passed &= check(badUVs == 0, "the texture coordinates of a mesh don't tile one texture per block");
+	}
+	return passed;
+}
+
+// Function which times generating (and unloading) chunks with each storage backend
+void SurfaceBenchmarks::benchmarkGeneration(){
+	// Load the map if this is the first benchmark run
+	getMap();
+	const int COUNT = 16;
+	for(Chunk::Storage storage: {Chunk::OCTREE, Chunk::PALETTED, Chunk::LINEAR}){
+		gout << "generating " << COUNT << " chunks with " << storageNames[storage] << " storage:" << endl;
+		map->storage = storage;
+		std::vector<Chunk*> generated;
+		{
+			Timer t;
+			for(int i = 0; i < COUNT; i++)
+				generated.push_back(map->generateChunk(Vector3(CHUNK_DIMENSIONS * (8 + i), 0, CHUNK_DIMENSIONS * 4)));
+		}
+		size_t memory = 0;
+		for(Chunk* c: generated)
+			memory += c->memoryUsage();
+		gout << "\t" << memory / COUNT << " bytes per chunk" << endl;
+		gout << "unloading them:" << endl;
+		{
+			Timer t;
+			for(Chunk* c: generated)
+				c->free();
+		}
+	}
+	map->storage = Chunk::OCTREE;
+}
+
+// Function which compares the speed and memory of the storage backends on the same terrain
+void SurfaceBenchmarks::benchmarkStorage(){
+	// Load the map if this is the first benchmark run
+	getMap();
+	for(Chunk::Storage storage: {Chunk::OCTREE, Chunk::PALETTED, Chunk::LINEAR}){
+		gout << storageNames[storage] << " storage:" << endl;
+		map->storage = storage;
+		Chunk* bench = map->generateChunk(Vector3(CHUNK_DIMENSIONS * 4, 0, 0));
+		int found = 0;
+		{
+			Timer t;
+			for(int x = 0; x < CHUNK_DIMENSIONS; x++)
+				for(int y = 0; y < CHUNK_DIMENSIONS; y++)
+					for(int z = 0; z < CHUNK_DIMENSIONS; z++)
+						found += bench->getBlockState(x, y, z);
+		}
+		gout << "\t" << found << " solid blocks, " << bench->memoryUsage() << " bytes" << endl;
+		bench->free();
+	}
+	map->storage = Chunk::OCTREE;
+}
+
+// Function which times collecting the faces of chunks where every block is randomly solid (should scale linearly)
+void SurfaceBenchmarks::benchmarkFaceCollection(){
+	// Load the map if this is the first benchmark run
+	getMap();
+	BlockDatabase* db = BlockDatabase::getSingleton();
+	std::vector<Chunk*> noisy;
+	for(int i = 0; i < 4; i++){
+		Chunk* n = Chunk::_new();
+		n->center = Vector3(CHUNK_DIMENSIONS * (8 + i), 0, 0);
+		n->initalize(map);
+		n->fillBlocks([db, i](int x, int y, int z){
+			unsigned int hash = (x * 73856093) ^ (y * 19349663) ^ (z * 83492791) ^ (i * 2654435761u);
+			return db->getDefaultState((hash >> 7) & 1);
+		});
+		noisy.push_back(n);
+	}
+	for(size_t count = 1; count <= noisy.size(); count *= 2){
+		gout << "collecting faces from " << count << " noisy chunks:" << endl;
+		std::vector<Face> faces;
+		{
+			Timer t;
+			for(size_t i = 0; i < count; i++)
+				noisy[i]->iterate(BLOCK_LEVEL, [&faces](VoxelInstance* v, int){ v->getFaces(faces); });
+		}
+		gout << "\t" << faces.size() << " faces" << endl;
+	}
+	for(Chunk* n: noisy)
+		n->free();
+}
+
+// Function which prints how many quads the chunk costs at each level of detail
+void SurfaceBenchmarks::benchmarkLevelsOfDetail(){
+	Chunk* c = getChunk();
+	gout << "quads at each level of detail:";
+	for(int levelOfDetail = 0; levelOfDetail <= SUBCHUNK_LEVELS; levelOfDetail++){
+		VoxelGrid grid;
+		grid.capture(*c, levelOfDetail);
+		gout << " " << BinaryMesher::mesh(grid).verts.size() / 4;
+	}
+	gout << endl;
+}
+
+// Function which times greedily meshing the same 64x64 patch of faces as layers of different sizes (larger chunks need fewer quads and draw calls)
+void SurfaceBenchmarks::benchmarkLayerSizes(){
+	const int PATCH = 64;
+	for(int size = 16; size <= PATCH; size *= 2){
+		gout << "greedy meshing a " << PATCH << "x" << PATCH << " patch as " << (PATCH / size) * (PATCH / size) << " layers of " << size << "x" << size << ":" << endl;
+		size_t quads = 0;
+		Timer t;
+		for(int tileX = 0; tileX < PATCH; tileX += size)
+			for(int tileZ = 0; tileZ < PATCH; tileZ += size){
+				Vector3 tileCenter(tileX + size / 2, 0, tileZ + size / 2);
+				std::vector<Face> faces;
+				for(int x = 0; x < size; x++)
+					for(int z = 0; z < size; z++){
+						// Blobs of three block types
+						int id = (((tileX + x) / 5) * 7 + ((tileZ + z) / 3) * 3) % 3;
+						faces.push_back(Surface::greedyQuad(TOP, tileCenter, x, z, 1, 1, id, size));
+					}
+				quads += Surface::GreedyMeshCoplanar(std::move(faces), TOP, tileCenter, size).verts.size() / 4;
+			}
+		gout << "\t" << quads << " quads" << endl;
+	}
+}
+
+// Function which times meshing snapshots of the chunk on the map's worker threads with each mesher
+void SurfaceBenchmarks::benchmarkWorkers(){
+	Chunk* c = getChunk();
+	for(int type = Mesher::BLOCKY; type <= Mesher::POLYGON; type++){
+		const Mesher* mesher = Mesher::get((Mesher::Type) type);
+		VoxelGrid grid;
+		grid.capture(*c);
+		size_t triangles = 0;
+		gout << "meshing the chunk 64 times with the " << mesher->getName() << " mesher:" << endl;
+		{
+			Timer t;
+			for(int i = 0; i < 64; i++)
+				triangles = mesher->mesh(grid).indecies.size() / 3;
+		}
+		gout << "\t" << triangles << " triangles" << endl;
+
+		gout << "meshing 64 snapshots with the " << mesher->getName() << " mesher on " << map->meshWorkers.threadCount() << " workers:" << endl;
+		{
+			Timer t;
+			for(int i = 0; i < 64; i++){
+				VoxelGrid snapshot;
+				snapshot.capture(*c);
+				map->meshWorkers.submit(std::move(snapshot), i, true, false, mesher);
+			}
+			map->meshWorkers.wait();
+		}
+		// None of the jobs were queued by the chunk, so their results can't be committed
+		map->meshWorkers.takeResults();
+	}
+}
+
+// Function which compares the triangles (and vertices) greedy quads, the best greedy sweep orientation, and triangulated polygons take
+// on the chunks around the origin, at full detail and at the level of detail distant chunks get the thorough meshers from
+// (and checks that the thorough meshers never take more triangles than the greedy quads)
+void SurfaceBenchmarks::benchmarkMeshers(){
+	// Load the map if this is the first benchmark run
+	getMap();
+	for(int levelOfDetail: {0, THOROUGH_MESH_LEVEL}){
+		std::vector<VoxelGrid> grids;
+		for(int x = -1; x <= 1; x++)
+			for(int y = -1; y <= 1; y++)
+				for(int z = -1; z <= 1; z++)
+					if(Chunk* neighbor = map->getChunk(ivec3(x, y, z))){
+						grids.emplace_back();
+						grids.back().capture(*neighbor, levelOfDetail);
+					}
+		size_t greedyTriangles = 0;
+		for(const Mesher* mesher: {Mesher::get(Mesher::BLOCKY), Mesher::get(Mesher::BLOCKY)->thorough(), Mesher::get(Mesher::POLYGON)}){
+			size_t triangles = 0, vertices = 0;
+			gout << "meshing " << grids.size() << " chunks at level of detail " << levelOfDetail << " with the " << mesher->getName() << " mesher:" << endl;
+			{
+				Timer t;
+				for(const VoxelGrid& grid: grids){
+					Surface surface = mesher->mesh(grid);
+					triangles += surface.indecies.size() / 3;
+					vertices += surface.verts.size();
+				}
+			}
+			gout << "\t" << triangles << " triangles " << vertices << " vertices" << endl;
+			// Both the best orientation and the polygons keep the greedy quads wherever they are cheaper
+			if(mesher == Mesher::get(Mesher::BLOCKY))
+				greedyTriangles = triangles;
+			else
+				check(triangles <= greedyTriangles, "a thorough mesher took more triangles than the greedy quads");
+		}
+	}
+}
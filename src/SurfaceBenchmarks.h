@@ -0,0 +1,82 @@
+#ifndef _SURFACE_BENCHMARKS_H_
+#define _SURFACE_BENCHMARKS_H_
+#include <Node.hpp>
+#include "world/ChunkMap.h"
+
+/*
+	Node which times the storage backends and meshers on the chunks around the
+	origin, and checks that the optimized paths build the same results as the
+	paths they replaced. Nothing runs until the node enters a scene (see
+	benchmarks.tscn) or one of its functions is called. Benchmarks only print
+	their timings, checks which fail are reported as errors.
+*/
+class SurfaceBenchmarks: public Node {
+	GODOT_CLASS(SurfaceBenchmarks, Node)
+public:
+	static void _register_methods(){
+		register_method("_ready", &SurfaceBenchmarks::_ready);
+		register_method("runAll", &SurfaceBenchmarks::runAll);
+		register_method("checkVisibility", &SurfaceBenchmarks::checkVisibility);
+		register_method("checkGreedyMeshing", &SurfaceBenchmarks::checkGreedyMeshing);
+		register_method("checkLayerMeshes", &SurfaceBenchmarks::checkLayerMeshes);
+		register_method("checkWelding", &SurfaceBenchmarks::checkWelding);
+		register_method("checkPalettedStorage", &SurfaceBenchmarks::checkPalettedStorage);
+		register_method("checkMaterials", &SurfaceBenchmarks::checkMaterials);
+		register_method("benchmarkGeneration", &SurfaceBenchmarks::benchmarkGeneration);
+		register_method("benchmarkStorage", &SurfaceBenchmarks::benchmarkStorage);
+		register_method("benchmarkFaceCollection", &SurfaceBenchmarks::benchmarkFaceCollection);
+		register_method("benchmarkLevelsOfDetail", &SurfaceBenchmarks::benchmarkLevelsOfDetail);
+		register_method("benchmarkLayerSizes", &SurfaceBenchmarks::benchmarkLayerSizes);
+		register_method("benchmarkWorkers", &SurfaceBenchmarks::benchmarkWorkers);
+		register_method("benchmarkMeshers", &SurfaceBenchmarks::benchmarkMeshers);
+	}
+	void _init() {}
+
+	void _ready(){ runAll(); }
+	// Function which runs every check and benchmark, returns the number of checks which failed
+	int runAll();
+
+	// Function which checks that the neighbor traversal visibility matches looking up every neighbor from the root of its chunk
+	bool checkVisibility();
+	// Function which checks that the bitmask greedy mesher builds the same quads as greedily meshing the faces layer by layer
+	bool checkGreedyMeshing();
+	// Function which checks that remeshing a single layer builds the same surface as that layer of the whole chunk's mesh
+	bool checkLayerMeshes();
+	// Function which checks that welding the chunk's plain and greedy meshes keeps every triangle
+	bool checkWelding();
+	// Function which checks that a paletted chunk reads back every state written to it while its palette grows and is compacted
+	bool checkPalettedStorage();
+	// Function which checks that a chunk drawn with two materials is split into two surfaces which keep every triangle and tile their textures
+	bool checkMaterials();
+
+	// Function which times generating (and unloading) chunks with each storage backend
+	void benchmarkGeneration();
+	// Function which compares the speed and memory of the storage backends on the same terrain
+	void benchmarkStorage();
+	// Function which times collecting the faces of chunks where every block is randomly solid (should scale linearly)
+	void benchmarkFaceCollection();
+	// Function which prints how many quads the chunk costs at each level of detail
+	void benchmarkLevelsOfDetail();
+	// Function which times greedily meshing the same patch of faces as layers of different sizes
+	void benchmarkLayerSizes();
+	// Function which times meshing snapshots of the chunk on the map's worker threads with each mesher
+	void benchmarkWorkers();
+	// Function which compares the time, triangles, and vertices each mesher takes on the chunks around the origin
+	// (and checks that the thorough meshers never take more triangles than the greedy quads)
+	void benchmarkMeshers();
+
+protected:
+	// The map the benchmarks run on (created the first time it is needed)
+	ChunkMap* map = nullptr;
+	// Number of checks which have failed
+	int failures = 0;
+
+	// Function which gets the map, loading the chunk at the origin if it isn't loaded yet
+	ChunkMap* getMap();
+	// Function which gets the chunk at the origin
+	Chunk* getChunk(){ return getMap()->getChunk(ivec3(0, 0, 0)); }
+	// Function which reports <what> as an error if the check didn't pass, returns <passed>
+	bool check(bool passed, const char* what);
+};
+
+#endif // _SURFACE_BENCHMARKS_H_
@@ -15,13 +15,14 @@
 #include "block/BlockDatabase.h"
 
 void SurfaceOptimization::_ready(){
-    gout << BlockDatabase::getSingleton()->getBlock(0)->checkFlag(BlockData::TRANSPARENT) << endl;
-    gout << BlockDatabase::getSingleton()->getBlock(1)->checkFlag(BlockData::TRANSPARENT) << endl;
+    BlockDatabase* db = BlockDatabase::getSingleton();
+    gout << db->getState(db->getDefaultState(0))->checkFlag(BlockData::TRANSPARENT) << endl;
+    gout << db->getState(db->getDefaultState(1))->checkFlag(BlockData::TRANSPARENT) << endl;
 
     ChunkMap* map = ChunkMap::_new();
     add_child(map);
 	
-	Chunk* c = map->chunk[1];
+	Chunk* c = map->getChunk(ivec3(0, 0, 0));
 	gout << c->flags << endl;
     c->rebuildMesh();
 	gout << c->get_mesh()->get_faces().size() / 3 << " faces originally" << endl;
@@ -1,5 +1,7 @@
 #include "BlockDatabase.h"
 
+Identifier Blocks::AIR;
+
 BlockDatabase* BlockDatabase::getSingleton(){
     static BlockDatabase db;
     return &db;
@@ -17,22 +19,39 @@ BlockDatabase::BlockDatabase(){
 // Function which adds a block to the database, returns ID of the newly added block
 Identifier BlockDatabase::addBlock(BlockData* d){
     blocks.push_back(d);
-    return blocks[blocks.size() - 1]->blockID = blocks.size() - 1;
+    d->blockID = blocks.size() - 1;
+    // The block's default state is a copy of the block itself
+    defaultStates.push_back(internState(new BlockData(*d)));
+    return d->blockID;
 }
 
 // Function which gets a copy of one of the blocks in the database
 BlockData* BlockDatabase::getBlock(Identifier id, bool loadFeatures){
     // If the id is outside of the array... return a nullptr
-    if(id > blocks.size()) return nullptr;
+    if(id >= blocks.size()) return nullptr;
 
     // TODO: support derived classes?
-    BlockData* out = new BlockData;
-    *out = *blocks[id];
-    return out;
+    return new BlockData(*blocks[id]);
+}
+
+// Function which finds (or adds) the state matching <data>, the database takes ownership of <data>
+BlockState BlockDatabase::internState(BlockData* data){
+    for(size_t i = 0; i < states.size(); i++)
+        if(*states[i] == *data){
+            delete data;
+            return i;
+        }
+
+    states.push_back(data);
+    unprunableStates.push_back(data->hasUnprunableFeature());
+    stateProperties.push_back({!data->checkFlag(BlockData::INVISIBLE), !data->checkFlag(BlockData::TRANSPARENT), data->blockID, data->material});
+    return states.size() - 1;
 }
 
 // Function which cleans up after the BlockManager
 BlockDatabase::~BlockDatabase(){
     for(BlockData* p: blocks)
         delete p;
+    for(BlockData* p: states)
+        delete p;
 }
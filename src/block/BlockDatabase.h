@@ -8,6 +8,8 @@
 
 typedef size_t Identifier;
 typedef unsigned short flag_t;
+// Index into the BlockDatabase's palette of immutable block states
+typedef unsigned short BlockState;
 
 using namespace godot;
 
@@ -26,17 +28,41 @@ public:
 	flag_t flags = 0;
 	// Variable storing the loaded features of this block
 	std::map<godot::String, Feature*> features;
-//	godot::Material mat;
+	// Index of the material the block is drawn with (see ChunkMap::materials), a chunk's mesh gets a surface per material
+	unsigned short material = 0;
 
 	// Constructer
-    BlockData(flag_t f = Flags::null, const std::initializer_list<godot::String> features = {}) : flags(f) {
+    BlockData(flag_t f = Flags::null, const std::initializer_list<godot::String> features = {}, unsigned short material = 0) : flags(f), material(material) {
 		this->features = BlockFeatureDatabase::getSingleton()->getFeatures(features);
 	}
+	// Copy constructor (creates its own copy of every feature)
+	BlockData(const BlockData& other) : blockID(other.blockID), flags(other.flags), material(other.material) {
+		for(auto feature: other.features)
+			features[feature.first] = feature.second->copy();
+	}
+	BlockData& operator=(const BlockData& other) = delete;
+	// Destructor
+	~BlockData(){
+		for(auto feature: features)
+			delete feature.second;
+	}
+
+	// Function which checks if two blocks are the same type and have the same feature values
+	bool operator==(const BlockData& other) const {
+		if(blockID != other.blockID || flags != other.flags || material != other.material || features.size() != other.features.size())
+			return false;
+		for(auto feature: features){
+			auto it = other.features.find(feature.first);
+			if(it == other.features.end() || !feature.second->equals(*it->second))
+				return false;
+		}
+		return true;
+	}
 
     // Function which compares the provided mask to the bitfield
 	bool checkFlag(Flags mask) const { return (flags & mask) == mask; }
 	// Function which checks if a block data instance has features which can't be pruned
-	bool hasUnprunableFeature() {
+	bool hasUnprunableFeature() const {
 		for(auto feature: features)
 			if (!feature.second->pruneable)
 				return true;
@@ -57,10 +83,37 @@ public:
 	}
 };
 
+// The properties of a block state which the meshers read, the database keeps a copy for every state so that
+// snapshots can carry them to the meshing workers without the workers reading the database (see VoxelGrid::properties)
+struct StateProperties {
+	// If the state has faces (isn't INVISIBLE)
+	bool solid;
+	// If the state hides the faces beside it (isn't TRANSPARENT)
+	bool opaque;
+	// The block the state belongs to (faces of different blocks aren't merged)
+	Identifier blockID;
+	// Index of the material the state is drawn with
+	unsigned short material;
+};
+
+/*
+	Every distinct combination of block type and feature values is stored once
+	in the database's palette of block states, voxels only store a BlockState
+	index into that palette. States are immutable once they have been added,
+	modifying a block means building a new BlockData and interning it.
+*/
 class BlockDatabase {
 public:
 	// Array storing the nessicary blocks
 	std::vector<BlockData*> blocks;
+	// Array storing every block state which is in use (shared by all voxels)
+	std::vector<BlockData*> states;
+	// Array storing the default state of each block
+	std::vector<BlockState> defaultStates;
+	// Array caching if each state has a feature which stops it from being pruned (indexed by state)
+	std::vector<bool> unprunableStates;
+	// Array storing the properties the meshers need of each state (indexed by state)
+	std::vector<StateProperties> stateProperties;
 	// Function which gets a reference to the singleton for the database
 	static BlockDatabase* getSingleton();
 
@@ -72,11 +125,21 @@ public:
     Identifier addBlock(BlockData* d);
     // Function which gets a copy of one of the blocks in the database
     BlockData* getBlock(Identifier id, bool loadFeatures = true);
+
+	// Function which gets the default state of a block
+	BlockState getDefaultState(Identifier id) const { return defaultStates[id]; }
+	// Function which gets the shared data of a block state
+	const BlockData* getState(BlockState state) const { return states[state]; }
+	// Function which checks if a block state has a feature which stops it from being pruned (cached when the state is interned)
+	bool isUnprunable(BlockState state) const { return unprunableStates[state]; }
+	// Function which finds (or adds) the state matching <data>, the database takes ownership of <data>
+	// NOTE: states should only be interned from the main thread, the meshing workers only read the copies of their properties in their snapshots
+	BlockState internState(BlockData* data);
 };
 
 // List of blocks... may remove it this proves unworthy of maintience
 namespace Blocks {
-	static Identifier AIR;
+	extern Identifier AIR;
 } // Blocks
 
 #endif // __BLOCK_MANAGER_H__
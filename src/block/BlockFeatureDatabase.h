@@ -18,6 +18,10 @@ public:
 	// Return a dynamically allocated copy of this feature, the constructor should only set a feature's name
 	// This function should act as a class's constructor
     virtual Feature* _new() const { return nullptr; }
+	// Return a dynamically allocated copy of this feature including its current values
+	virtual Feature* copy() const { return _new(); }
+	// Function which checks if two features hold the same values (blocks with equal features share a block state)
+	virtual bool equals(const Feature& other) const { return name == other.name; }
 
 	// Functions which dictate what hapens when this feature is loaded/saved from disc
 	virtual void save(oarchive& archive) const {}
@@ -15,6 +15,10 @@ public:
     virtual ~OrientationFeature(){}
 
     virtual Feature* _new() const { return new OrientationFeature(); }
+    virtual Feature* copy() const { return new OrientationFeature(*this); }
+    virtual bool equals(const Feature& other) const {
+        return other.is(Features::ORIENTATION) && orientation == static_cast<const OrientationFeature&>(other).orientation;
+    }
 
     virtual void load(iarchive& archive){ archive(cereal::make_nvp("Orientation", orientation)); }
     virtual void save(oarchive& archive) const { archive(cereal::make_nvp("Orientation", orientation)); }
@@ -1,4 +1,5 @@
 #include "../SurfaceOptimization.h"
+#include "../SurfaceBenchmarks.h"
 #include "../world/Chunk.h"
 #include "../world/ChunkMap.h"
 
@@ -16,6 +17,7 @@ extern "C" void GDN_EXPORT godot_nativescript_init(void *handle) {
 	godot::Godot::nativescript_init(handle);
 
 	godot::register_class<SurfaceOptimization>();
+	godot::register_class<SurfaceBenchmarks>();
 	godot::register_class<ChunkMap>();
 	godot::register_class<Chunk>();
 }
@@ -0,0 +1,263 @@
+#include "BinaryMesher.h"
+
+#include <vector>
+#include <algorithm>
+
+#include "../block/BlockDatabase.h"
+
+static_assert(VoxelGrid::SIZE <= sizeof(BinaryMesher::Row) * 8, "A row must be able to hold a column of the grid");
+
+// Bitmasks of the visible faces of a single block ID, indexed by [Direction][slice][first axis] with a bit per cell along the second axis
+struct SliceMasks {
+	BinaryMesher::Row rows[6][CHUNK_DIMENSIONS][CHUNK_DIMENSIONS];
+};
+
+// Function which gets the index of the lowest set bit in a non-zero row (of either width)
+static inline int lowestBit(uint32_t row){ return __builtin_ctz(row); }
+static inline int lowestBit(uint64_t row){ return __builtin_ctzll(row); }
+
+// Function which gets the center of the <slice>th layer of the chunk coming from direction <d> (matches Chunk::buildCoplanarSurface)
+static Vector3 layerCenter(Vector3 center, int d, int slice){
+	int offset = slice - CHUNK_DIMENSIONS / 2;
+	switch(d){
+	case TOP: return center - Vector3(0, offset, 0);
+	case BOTTOM: return center + Vector3(0, offset, 0);
+	case NORTH: return center - Vector3(offset, 0, 0);
+	case SOUTH: return center + Vector3(offset, 0, 0);
+	case EAST: return center - Vector3(0, 0, offset);
+	case WEST: return center + Vector3(0, 0, offset);
+	}
+	return center;
+}
+
+// Function which greedily merges the faces in the rows of a slice into quads, <out> needs room for a quad per cell,
+// returns the number of quads (the rows are cleared)
+int BinaryMesher::greedyQuads(Row* rows, Quad* out){
+	const int N = CHUNK_DIMENSIONS;
+	int count = 0;
+	for(int first = 0; first < N; first++)
+		while(rows[first]){
+			// The quad is as wide as the run of faces starting at the first face in the row...
+			int second = lowestBit(rows[first]);
+			int w = lowestBit(~(rows[first] >> second));
+			Row run = ((Row(1) << w) - 1) << second;
+			rows[first] &= ~run;
+			// And as tall as the number of rows below it which contain the whole run
+			int h = 1;
+			for(; first + h < N && (rows[first + h] & run) == run; h++)
+				rows[first + h] &= ~run;
+
+			out[count++] = {first, second, h, w};
+		}
+	return count;
+}
+
+// Function which greedily merges the faces in the rows of a slice into quads (the default SliceMerger)
+void BinaryMesher::greedySlice(Row* rows, Direction d, Vector3 center, int blockID, Surface& out){
+	Quad quads[CHUNK_DIMENSIONS * CHUNK_DIMENSIONS];
+	int count = greedyQuads(rows, quads);
+	for(int q = 0; q < count; q++)
+		out += Surface::greedyQuad(d, center, quads[q].first, quads[q].second, quads[q].h, quads[q].w, blockID, CHUNK_DIMENSIONS);
+}
+
+// Function which reverses the order of the bits for the cells of a row
+static inline BinaryMesher::Row reverseRow(BinaryMesher::Row row){
+	typedef BinaryMesher::Row Row;
+	const int BITS = sizeof(Row) * 8;
+	// Swap neighboring bits, then pairs, then nibbles... (~0 / (2^width + 1) alternates <width> clear and set bits, 0x5555... 0x3333... etc)
+	for(int width = 1; width < BITS; width *= 2){
+		Row mask = ~Row(0) / ((Row(1) << width) + 1);
+		row = ((row >> width) & mask) | ((row & mask) << width);
+	}
+	return row >> (BITS - CHUNK_DIMENSIONS);
+}
+
+// Function which greedily merges the faces in the rows of a slice into quads with the slice flipped and/or transposed first
+// (bit 0 of <orientation> flips the first axis, bit 1 flips the second axis, and bit 2 swaps the axes), so the sweep starts
+// from a different corner and runs along a different axis, the quads are mapped back onto the slice (the rows are left alone)
+static int orientedQuads(const BinaryMesher::Row* rows, int orientation, BinaryMesher::Quad* out){
+	typedef BinaryMesher::Row Row;
+	const int N = CHUNK_DIMENSIONS;
+	Row oriented[N] = {};
+	for(int first = 0; first < N; first++)
+		if(orientation & 4){
+			for(Row row = rows[first]; row; row &= row - 1)
+				oriented[lowestBit(row)] |= Row(1) << first;
+		} else
+			oriented[first] = rows[first];
+	if(orientation & 1)
+		std::reverse(oriented, oriented + N);
+	if(orientation & 2)
+		for(int first = 0; first < N; first++)
+			oriented[first] = reverseRow(oriented[first]);
+
+	int count = BinaryMesher::greedyQuads(oriented, out);
+	for(int q = 0; q < count; q++){
+		BinaryMesher::Quad& quad = out[q];
+		if(orientation & 2) quad.second = N - quad.second - quad.w;
+		if(orientation & 1) quad.first = N - quad.first - quad.h;
+		if(orientation & 4){
+			std::swap(quad.first, quad.second);
+			std::swap(quad.h, quad.w);
+		}
+	}
+	return count;
+}
+
+// Function which greedily merges the faces in the rows of a slice into quads sweeping from every corner along both axes,
+// and keeps whichever sweep needs the fewest quads (a SliceMerger)
+void BinaryMesher::bestOrientationSlice(Row* rows, Direction d, Vector3 center, int blockID, Surface& out){
+	const int N = CHUNK_DIMENSIONS;
+	Row any = 0;
+	for(int first = 0; first < N; first++)
+		any |= rows[first];
+	if(!any) return;
+
+	Quad best[N * N], quads[N * N];
+	int bestCount = N * N + 1;
+	for(int orientation = 0; orientation < ORIENTATIONS; orientation++){
+		int count = orientedQuads(rows, orientation, quads);
+		if(count < bestCount){
+			bestCount = count;
+			std::copy(quads, quads + count, best);
+		}
+	}
+
+	for(int q = 0; q < bestCount; q++)
+		out += Surface::greedyQuad(d, center, best[q].first, best[q].second, best[q].h, best[q].w, blockID, N);
+	std::fill(rows, rows + N, 0);
+}
+
+// Function which builds the greedily optimized surface of the chunk captured in <grid>
+Surface BinaryMesher::mesh(const VoxelGrid& grid, SliceMerger merge /*= greedySlice*/){
+	Chunk::LayerSurfaces layers;
+	mesh(grid, layers, merge);
+	return Chunk::joinLayers(layers);
+}
+
+// Function which builds the greedily optimized surface of the chunk captured in <grid> split up by layer
+void BinaryMesher::mesh(const VoxelGrid& grid, Chunk::LayerSurfaces& out, SliceMerger merge /*= greedySlice*/){
+	const int N = CHUNK_DIMENSIONS;
+
+	// Widen the properties of every state once (solid blocks have faces, opaque blocks hide the faces beside them)
+	size_t stateCount = grid.properties.size();
+	std::vector<Row> solid(stateCount), opaque(stateCount);
+	for(size_t s = 0; s < stateCount; s++){
+		solid[s] = grid.properties[s].solid;
+		opaque[s] = grid.properties[s].opaque;
+	}
+
+	// Pack the blocks along each axis into columns, bit i + 1 is block i along the axis (bits 0 and N + 1 are the border)
+	// Axis 0 runs along x (indexed by [y][z]), axis 1 along y (indexed by [x][z]), and axis 2 along z (indexed by [x][y])
+	Row solidColumns[3][N][N] = {}, opaqueColumns[3][N][N] = {};
+	for(int x = -1; x <= N; x++)
+		for(int z = -1; z <= N; z++)
+			for(int y = -1; y <= N; y++){
+				bool insideX = x >= 0 && x < N, insideY = y >= 0 && y < N, insideZ = z >= 0 && z < N;
+				// Only the chunk and the border touching its faces matter
+				if(insideX + insideY + insideZ < 2) continue;
+				BlockState state = grid.get(x, y, z);
+				// Missing neighbors are empty space
+				if(state == VoxelGrid::NONE) continue;
+
+				if(insideY && insideZ){
+					solidColumns[0][y][z] |= solid[state] << (x + 1);
+					opaqueColumns[0][y][z] |= opaque[state] << (x + 1);
+				}
+				if(insideX && insideZ){
+					solidColumns[1][x][z] |= solid[state] << (y + 1);
+					opaqueColumns[1][x][z] |= opaque[state] << (y + 1);
+				}
+				if(insideX && insideY){
+					solidColumns[2][x][y] |= solid[state] << (z + 1);
+					opaqueColumns[2][x][y] |= opaque[state] << (z + 1);
+				}
+			}
+
+	// Faces with different block IDs can't be merged, so each ID gets its own set of masks
+	std::vector<SliceMasks> masks;
+	std::vector<int> maskIDs, maskMaterials;
+	auto masksFor = [&masks, &maskIDs, &maskMaterials](const StateProperties& state) -> SliceMasks& {
+		for(size_t m = 0; m < maskIDs.size(); m++)
+			if(maskIDs[m] == (int) state.blockID)
+				return masks[m];
+		maskIDs.push_back(state.blockID);
+		maskMaterials.push_back(state.material);
+		masks.emplace_back();
+		return masks.back();
+	};
+
+	// Find the visible faces in every column and scatter them into the slices
+	const Row inside = ((Row(1) << N) - 1) << 1;
+	static const Direction positive[3] = {NORTH, TOP, EAST}, negative[3] = {SOUTH, BOTTOM, WEST};
+	for(int axis = 0; axis < 3; axis++)
+		for(int u = 0; u < N; u++)
+			for(int v = 0; v < N; v++){
+				Row s = solidColumns[axis][u][v], o = opaqueColumns[axis][u][v];
+				// A face is visible when its block is solid and the block beside it isn't opaque
+				Row faces[2] = {s & ~(o >> 1) & inside, s & ~(o << 1) & inside};
+				for(int side = 0; side < 2; side++)
+					for(Row f = faces[side]; f; f &= f - 1){
+						int i = lowestBit(f) - 1;
+						BlockState state = axis == 0 ? grid.get(i, u, v) : axis == 1 ? grid.get(u, i, v) : grid.get(u, v, i);
+						// Layers are counted from the side the faces point towards
+						int slice = side ? i : N - 1 - i;
+						Direction d = side ? negative[axis] : positive[axis];
+						masksFor(grid.properties[state]).rows[d][slice][u] |= Row(1) << v;
+					}
+			}
+
+	// Merge the faces in each slice (the triangles are drawn with the material of their block)
+	for(int d = NORTH; d <= BOTTOM; d++)
+		for(int slice = 0; slice < N; slice++){
+			out[d][slice] = Surface();
+			Vector3 center = layerCenter(grid.center, d, slice);
+			for(size_t m = 0; m < masks.size(); m++){
+				size_t firstTriangle = out[d][slice].indecies.size() / 3;
+				merge(masks[m].rows[d][slice], (Direction) d, center, maskIDs[m], out[d][slice]);
+				out[d][slice].setMaterial(firstTriangle, maskMaterials[m]);
+			}
+		}
+}
+
+// Function which builds the greedily optimized surface of a single layer, only the blocks in the layer
+// and the blocks touching the faces of the layer are read from <grid> (see VoxelGrid::captureLayer)
+Surface BinaryMesher::meshLayer(const VoxelGrid& grid, Direction d, int layer, SliceMerger merge /*= greedySlice*/){
+	const int N = CHUNK_DIMENSIONS;
+	int axis = axisOf(d);
+	// Position of the layer along the axis and of the blocks its faces touch
+	int i = isPositive(d) ? N - 1 - layer : layer, beside = isPositive(d) ? i + 1 : i - 1;
+	// Cell (<u>, <v>) of the layer is the block at <along> on the axis (u and v are the first and second axes of the slice)
+	auto at = [&grid, axis](int along, int u, int v){
+		return axis == 0 ? grid.get(along, u, v) : axis == 1 ? grid.get(u, along, v) : grid.get(u, v, along);
+	};
+
+	// Faces with different block IDs can't be merged, so each ID gets its own rows
+	std::vector<Row> rows;
+	std::vector<int> rowIDs, rowMaterials;
+	for(int u = 0; u < N; u++)
+		for(int v = 0; v < N; v++){
+			BlockState state = at(i, u, v), next = at(beside, u, v);
+			const StateProperties& properties = grid.properties[state];
+			// A face is visible when its block is solid and the block beside it isn't opaque (missing neighbors are empty space)
+			if(!properties.solid) continue;
+			if(next != VoxelGrid::NONE && grid.properties[next].opaque) continue;
+
+			size_t m = std::find(rowIDs.begin(), rowIDs.end(), (int) properties.blockID) - rowIDs.begin();
+			if(m == rowIDs.size()){
+				rowIDs.push_back(properties.blockID);
+				rowMaterials.push_back(properties.material);
+				rows.resize(rows.size() + N, 0);
+			}
+			rows[m * N + u] |= Row(1) << v;
+		}
+
+	Surface out;
+	Vector3 center = layerCenter(grid.center, d, layer);
+	for(size_t m = 0; m < rowIDs.size(); m++){
+		size_t firstTriangle = out.indecies.size() / 3;
+		merge(&rows[m * N], d, center, rowIDs[m], out);
+		out.setMaterial(firstTriangle, rowMaterials[m]);
+	}
+	return out;
+}
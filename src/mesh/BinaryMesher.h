@@ -0,0 +1,50 @@
+#ifndef __BINARY_MESHER_H__
+#define __BINARY_MESHER_H__
+#include <cstdint>
+#include <type_traits>
+
+#include "../SurfFaceEdge.h"
+#include "VoxelGrid.h"
+
+/*
+	Greedy mesher which works on bitmasks instead of lists of faces. The solid and
+	opaque blocks along every column of the grid are packed into a single word, so
+	the visible faces of a whole column are found with a shift and an AND. The faces
+	are then scattered into a bitmask per slice (one word per row) and merged into
+	quads by scanning for runs of set bits. Produces the same quads as running
+	Surface::GreedyMeshCoplanar over every layer of the chunk, except that faces are
+	culled block by block (pruned voxels don't keep faces hidden by their neighbors).
+	How the faces of a slice are merged can be swapped out (see PolygonMesher).
+*/
+class BinaryMesher {
+public:
+	// Type storing one row/column of a bitmask (needs a bit for every block along a side of the grid, so chunks
+	// wider than 30 blocks switch to 64 bit rows)
+	typedef std::conditional<VoxelGrid::SIZE <= 32, uint32_t, uint64_t>::type Row;
+	// Type of the functions which merge the faces of a single block ID in a slice into a surface, the slice has a row for every cell
+	// along its first axis with a bit for every cell along its second axis (see Surface::GreedyMeshCoplanar for which axes those are),
+	// <center> is the center of the slice and the rows are cleared
+	typedef void (*SliceMerger)(Row* rows, Direction d, Vector3 center, int blockID, Surface& out);
+	// Rectangle of faces in a slice covering <h> cells along the first axis and <w> cells along the second axis starting at cell (<first>, <second>)
+	struct Quad { int first, second, h, w; };
+
+	// Function which greedily merges the faces in the rows of a slice into quads, <out> needs room for a quad per cell,
+	// returns the number of quads (the rows are cleared)
+	static int greedyQuads(Row* rows, Quad* out);
+	// Function which greedily merges the faces in the rows of a slice into quads (the default SliceMerger)
+	static void greedySlice(Row* rows, Direction d, Vector3 center, int blockID, Surface& out);
+	// The number of ways bestOrientationSlice sweeps over a slice (from each of the four corners, along each of the two axes)
+	static const int ORIENTATIONS = 8;
+	// Function which greedily merges the faces in the rows of a slice into quads sweeping from every corner along both axes,
+	// and keeps whichever sweep needs the fewest quads (a SliceMerger)
+	static void bestOrientationSlice(Row* rows, Direction d, Vector3 center, int blockID, Surface& out);
+	// Function which builds the greedily optimized surface of the chunk captured in <grid>
+	static Surface mesh(const VoxelGrid& grid, SliceMerger merge = greedySlice);
+	// Function which builds the greedily optimized surface of the chunk captured in <grid> split up by layer
+	static void mesh(const VoxelGrid& grid, Chunk::LayerSurfaces& out, SliceMerger merge = greedySlice);
+	// Function which builds the greedily optimized surface of a single layer, only the blocks in the layer
+	// and the blocks touching the faces of the layer are read from <grid> (see VoxelGrid::captureLayer)
+	static Surface meshLayer(const VoxelGrid& grid, Direction d, int layer, SliceMerger merge = greedySlice);
+};
+
+#endif // __BINARY_MESHER_H__
@@ -0,0 +1,117 @@
+#include "MarchingCubesMesher.h"
+
+#include <vector>
+#include <algorithm>
+
+// Function which gets the lookup table of the triangles in a cell, indexed by which corners are solid, each entry
+// lists the edges (see Mesher::CUBE_EDGES) the corners of the triangles lie on and ends with a -1
+const int8_t (*MarchingCubesMesher::triangleTable())[16] {
+	struct Table {
+		int8_t triangles[256][16];
+		Table(){
+			// The corners of each face of a cell, counter clockwise seen from outside of the cell
+			static const int faces[6][4] = {{0, 4, 6, 2}, {1, 3, 7, 5}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 2, 3, 1}, {4, 5, 7, 6}};
+			auto edgeBetween = [](int a, int b){
+				for(int e = 0; e < 12; e++)
+					if((CUBE_EDGES[e][0] == a && CUBE_EDGES[e][1] == b) || (CUBE_EDGES[e][0] == b && CUBE_EDGES[e][1] == a))
+						return e;
+				return -1;
+			};
+
+			for(int mask = 0; mask < 256; mask++){
+				auto solid = [mask](int corner){ return bool(mask >> corner & 1); };
+				// On each face the surface runs from the edge where the walk around the face leaves a group of solid corners
+				// to the edge where it entered that group, since neighboring faces walk their shared edge in opposite directions
+				// the edge a face's line ends on is the edge the next face's line starts from
+				int next[12];
+				std::fill(next, next + 12, -1);
+				for(const int* face: faces)
+					for(int k = 0; k < 4; k++){
+						if(!solid(face[k]) || solid(face[(k + 1) % 4])) continue;
+						int j = k;
+						while(solid(face[(j + 3) % 4]))
+							j = (j + 3) % 4;
+						next[edgeBetween(face[k], face[(k + 1) % 4])] = edgeBetween(face[(j + 3) % 4], face[j]);
+					}
+
+				// Follow the lines around each loop and split it into a fan of triangles
+				int count = 0;
+				bool used[12] = {};
+				for(int start = 0; start < 12; start++){
+					if(next[start] < 0 || used[start]) continue;
+					std::vector<int> loop;
+					for(int e = start; !used[e]; e = next[e]){
+						used[e] = true;
+						loop.push_back(e);
+					}
+					for(size_t i = 1; i + 1 < loop.size(); i++){
+						triangles[mask][count++] = loop[0];
+						triangles[mask][count++] = loop[i];
+						triangles[mask][count++] = loop[i + 1];
+					}
+				}
+				std::fill(triangles[mask] + count, triangles[mask] + 16, -1);
+			}
+		}
+	};
+	// Built once, the first time any thread needs it
+	static const Table table;
+	return table.triangles;
+}
+
+// Function which builds the smooth surface of the chunk captured in <grid>
+Surface MarchingCubesMesher::mesh(const VoxelGrid& grid) const {
+	const int N = CHUNK_DIMENSIONS;
+	const int8_t (*triangles)[16] = triangleTable();
+	std::vector<float> density = sampleDensity(grid);
+	Vector3 origin = sampleOrigin(grid);
+	Surface out;
+
+	auto at = [&density](int x, int y, int z){ return density[VoxelGrid::index(x, y, z)]; };
+	// Function which finds the gradient of the density at a sample (one sided at the border of the grid)
+	auto gradient = [&at, N](int x, int y, int z){
+		auto difference = [&at, N](int p[3], int axis){
+			int lo[3] = {p[0], p[1], p[2]}, hi[3] = {p[0], p[1], p[2]};
+			lo[axis] = std::max(p[axis] - 1, -1);
+			hi[axis] = std::min(p[axis] + 1, N);
+			return (at(hi[0], hi[1], hi[2]) - at(lo[0], lo[1], lo[2])) / (hi[axis] - lo[axis]);
+		};
+		int p[3] = {x, y, z};
+		return Vector3(difference(p, 0), difference(p, 1), difference(p, 2));
+	};
+
+	// Index of the vertex on each edge between two samples, indexed by the sample at the start of the edge (0 to N along each axis)
+	// and the axis the edge runs along, -1 until a cell needs it
+	const int SAMPLES = N + 1;
+	std::vector<int> edgeVertex(SAMPLES * SAMPLES * SAMPLES * 3, -1);
+	auto vertexOn = [&](int x, int y, int z, int e) -> int {
+		int a = CUBE_EDGES[e][0], b = CUBE_EDGES[e][1], axis = e / 4;
+		int sx = x + (a & 1), sy = y + (a >> 1 & 1), sz = z + (a >> 2 & 1);
+		int& index = edgeVertex[((sx * SAMPLES + sz) * SAMPLES + sy) * 3 + axis];
+		if(index >= 0) return index;
+
+		int ex = x + (b & 1), ey = y + (b >> 1 & 1), ez = z + (b >> 2 & 1);
+		float da = at(sx, sy, sz), db = at(ex, ey, ez);
+		float t = (ISO_LEVEL - da) / (db - da);
+		// The density increases into the solid, so the normal points down its gradient
+		Vector3 normal = -gradient(sx, sy, sz).linear_interpolate(gradient(ex, ey, ez), t);
+
+		index = out.verts.size();
+		out.verts.push_back(origin + Vector3(sx, sy, sz).linear_interpolate(Vector3(ex, ey, ez), t));
+		out.norms.push_back(normal == Vector3(0, 0, 0) ? normal : normal.normalized());
+		return index;
+	};
+
+	for(int x = 0; x < N; x++)
+		for(int z = 0; z < N; z++)
+			for(int y = 0; y < N; y++){
+				int mask = 0;
+				for(int i = 0; i < 8; i++)
+					mask |= (at(x + (i & 1), y + (i >> 1 & 1), z + (i >> 2 & 1)) >= ISO_LEVEL) << i;
+				for(const int8_t* e = triangles[mask]; *e >= 0; e++)
+					out.indecies.push_back(vertexOn(x, y, z, *e));
+			}
+
+	fillMissingNormals(out);
+	return out;
+}
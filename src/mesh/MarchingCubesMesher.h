@@ -0,0 +1,33 @@
+#ifndef __MARCHING_CUBES_MESHER_H__
+#define __MARCHING_CUBES_MESHER_H__
+
+#include <cstdint>
+
+#include "Mesher.h"
+
+/*
+	Smooth mesher which walks over every cell (the cube between eight neighboring
+	block centers) and looks up the triangles separating its solid corners from
+	its empty ones in a table indexed by which corners are solid. Vertices lie on
+	the cell edges the surface crosses and are cached by edge, so the cells
+	sharing an edge share its vertex. The table is built from the faces of the
+	cube (the ambiguous faces always keep their solid corners apart) which makes
+	neighboring cells, and chunks, agree on every face and leaves no holes. A
+	chunk owns the cells starting at its own blocks. Samples are taken at every
+	block, at lower levels of detail the blocks of the grid already hold the
+	coarser voxels so only the shape gets coarser.
+*/
+class MarchingCubesMesher: public Mesher {
+public:
+	const char* getName() const override { return "marching cubes"; }
+	// Function which builds the smooth surface of the chunk captured in <grid>
+	Surface mesh(const VoxelGrid& grid) const override;
+	bool readsDiagonals() const override { return true; }
+
+protected:
+	// Function which gets the lookup table of the triangles in a cell, indexed by which corners are solid, each entry
+	// lists the edges (see Mesher::CUBE_EDGES) the corners of the triangles lie on and ends with a -1
+	static const int8_t (*triangleTable())[16];
+};
+
+#endif // __MARCHING_CUBES_MESHER_H__
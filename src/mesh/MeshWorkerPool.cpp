@@ -0,0 +1,99 @@
+#include "MeshWorkerPool.h"
+
+#include <algorithm>
+
+// Creates a pool with <threads> workers (0 uses one less than the number of cores), the threads are started when the first job is queued
+MeshWorkerPool::MeshWorkerPool(size_t threads /*= 0*/){
+	if(!threads){
+		size_t cores = std::thread::hardware_concurrency();
+		threads = cores > 1 ? cores - 1 : 1;
+	}
+	size = threads;
+}
+
+MeshWorkerPool::~MeshWorkerPool(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	queued.notify_all();
+	for(std::thread& worker: workers)
+		worker.join();
+}
+
+// Function which queues the chunk captured in <grid> to be meshed by <mesher> (nullptr uses the blocky mesher, lower <priority> is meshed first),
+// if <wireframe> is set the outline of the mesh is built along with it, returns the generation of the job
+uint64_t MeshWorkerPool::submit(VoxelGrid&& grid, float priority, bool weld /*= true*/, bool wireframe /*= false*/, const Mesher* mesher /*= nullptr*/){
+	uint64_t generation;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(workers.empty())
+			for(size_t i = 0; i < size; i++)
+				workers.emplace_back(&MeshWorkerPool::work, this);
+
+		generation = nextGeneration++;
+		jobs.push_back({std::move(grid), priority, generation, weld, wireframe, mesher ? mesher : Mesher::get(Mesher::BLOCKY)});
+		std::push_heap(jobs.begin(), jobs.end());
+	}
+	queued.notify_one();
+	return generation;
+}
+
+// Function which takes all of the meshes which have finished since the last call
+std::vector<MeshWorkerPool::Result> MeshWorkerPool::takeResults(){
+	std::vector<Result> out;
+	std::lock_guard<std::mutex> lock(mutex);
+	out.swap(results);
+	return out;
+}
+
+// Function which blocks until every queued job has finished
+void MeshWorkerPool::wait(){
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this]{ return jobs.empty() && !running; });
+}
+
+// Function which gets the number of jobs which are queued or running
+size_t MeshWorkerPool::pending(){
+	std::lock_guard<std::mutex> lock(mutex);
+	return jobs.size() + running;
+}
+
+// Function run by each worker thread
+void MeshWorkerPool::work(){
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true){
+		queued.wait(lock, [this]{ return stopping || !jobs.empty(); });
+		if(stopping) return;
+
+		// Take the closest job
+		std::pop_heap(jobs.begin(), jobs.end());
+		Job job = std::move(jobs.back());
+		jobs.pop_back();
+		running++;
+		lock.unlock();
+
+		// Mesh the snapshot without holding the lock
+		Result r;
+		r.chunk = Chunk::chunkPositionOf(job.grid.center);
+		r.generation = job.generation;
+		r.levelOfDetail = job.grid.levelOfDetail;
+		r.layers.reset(new Chunk::LayerSurfaces);
+		if(job.mesher->meshLayers(job.grid, *r.layers))
+			r.surface = Chunk::joinLayers(*r.layers);
+		// Meshers which don't produce layers mesh the whole chunk at once
+		else {
+			r.layers.reset();
+			r.surface = job.mesher->mesh(job.grid);
+		}
+		if(job.weld) r.surface.weld();
+		r.surface.translate(-job.grid.center);
+		r.outlined = job.wireframe;
+		if(job.wireframe) r.wireframe = r.surface.getWireframe();
+
+		lock.lock();
+		results.push_back(std::move(r));
+		running--;
+		finished.notify_all();
+	}
+}
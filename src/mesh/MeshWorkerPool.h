@@ -0,0 +1,95 @@
+#ifndef __MESH_WORKER_POOL_H__
+#define __MESH_WORKER_POOL_H__
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+
+#include "VoxelGrid.h"
+#include "Mesher.h"
+
+/*
+	Fixed size pool of threads which mesh chunks in the background. Each
+	job carries a VoxelGrid snapshot of its chunk so the workers never touch the
+	octree, and jobs are run closest to the viewer first. Finished meshes wait in
+	a queue until the main thread takes them (only the main thread may touch the
+	scene). A job can also outline its mesh so the wireframe is always committed
+	together with the mesh it shows. Every job is tagged with a generation which
+	is never reused, a chunk remembers the generation of its latest job so results
+	which were superseded (or whose chunk was unloaded) can be dropped instead of
+	committed.
+*/
+class MeshWorkerPool {
+public:
+	// A finished mesh
+	struct Result {
+		// Chunk coordinates of the chunk the mesh belongs to
+		ivec3 chunk;
+		// The generation the job was queued with
+		uint64_t generation;
+		// The level of detail the chunk was meshed at
+		int levelOfDetail;
+		// The mesh split up by layer, nullptr if the mesher doesn't produce layers
+		std::unique_ptr<Chunk::LayerSurfaces> layers;
+		// The layers joined together (and welded if requested), in chunk space
+		Surface surface;
+		// Variable tracking if a wireframe was requested (and built from <surface>)
+		bool outlined;
+		// Line list outlining <surface> (empty unless <outlined>)
+		Surface wireframe;
+	};
+
+	// Creates a pool with <threads> workers (0 uses one less than the number of cores), the threads are started when the first job is queued
+	MeshWorkerPool(size_t threads = 0);
+	~MeshWorkerPool();
+	// The pool owns its threads, so it can't be copied
+	MeshWorkerPool(const MeshWorkerPool&) = delete;
+	MeshWorkerPool& operator=(const MeshWorkerPool&) = delete;
+
+	// Function which queues the chunk captured in <grid> to be meshed by <mesher> (nullptr uses the blocky mesher, lower <priority> is meshed first),
+	// if <wireframe> is set the outline of the mesh is built along with it, returns the generation of the job
+	uint64_t submit(VoxelGrid&& grid, float priority, bool weld = true, bool wireframe = false, const Mesher* mesher = nullptr);
+	// Function which takes all of the meshes which have finished since the last call
+	std::vector<Result> takeResults();
+	// Function which blocks until every queued job has finished
+	void wait();
+	// Function which gets the number of jobs which are queued or running
+	size_t pending();
+	// Function which gets the number of worker threads
+	size_t threadCount() const { return size; }
+
+protected:
+	struct Job {
+		VoxelGrid grid;
+		float priority;
+		uint64_t generation;
+		bool weld;
+		bool wireframe;
+		const Mesher* mesher;
+		// Orders the heap so the job with the lowest priority is on top
+		bool operator<(const Job& o) const { return priority > o.priority; }
+	};
+
+	size_t size;
+	std::vector<std::thread> workers;
+	// Heap of the jobs waiting for a worker
+	std::vector<Job> jobs;
+	std::vector<Result> results;
+	// The number of jobs a worker is currently meshing
+	size_t running = 0;
+	uint64_t nextGeneration = 1;
+	bool stopping = false;
+
+	std::mutex mutex;
+	// Signaled when a job is queued (or the pool is stopping)
+	std::condition_variable queued;
+	// Signaled when a job finishes
+	std::condition_variable finished;
+
+	// Function run by each worker thread
+	void work();
+};
+
+#endif // __MESH_WORKER_POOL_H__
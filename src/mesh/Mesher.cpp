@@ -0,0 +1,90 @@
+#include "Mesher.h"
+
+#include "BinaryMesher.h"
+#include "SurfaceNetsMesher.h"
+#include "MarchingCubesMesher.h"
+#include "PolygonMesher.h"
+#include "../block/BlockDatabase.h"
+
+constexpr float Mesher::ISO_LEVEL;
+const int Mesher::CUBE_EDGES[12][2] = {
+	{0, 1}, {2, 3}, {4, 5}, {6, 7},
+	{0, 2}, {1, 3}, {4, 6}, {5, 7},
+	{0, 4}, {1, 5}, {2, 6}, {3, 7}
+};
+
+// Function which gets the shared instance of the mesher of the given <type>
+const Mesher* Mesher::get(Type type){
+	static const BlockyMesher blocky;
+	static const SurfaceNetsMesher surfaceNets;
+	static const MarchingCubesMesher marchingCubes;
+	static const PolygonMesher polygon;
+	switch(type){
+	case SURFACE_NETS: return &surfaceNets;
+	case MARCHING_CUBES: return &marchingCubes;
+	case POLYGON: return &polygon;
+	default: return &blocky;
+	}
+}
+
+// Function which builds the greedily optimized surface of the chunk captured in <grid>
+Surface BlockyMesher::mesh(const VoxelGrid& grid) const {
+	return BinaryMesher::mesh(grid, bestOrientation ? BinaryMesher::bestOrientationSlice : BinaryMesher::greedySlice);
+}
+
+// Function which builds the greedily optimized surface of the chunk captured in <grid> split up by layer
+bool BlockyMesher::meshLayers(const VoxelGrid& grid, Chunk::LayerSurfaces& out) const {
+	BinaryMesher::mesh(grid, out, bestOrientation ? BinaryMesher::bestOrientationSlice : BinaryMesher::greedySlice);
+	return true;
+}
+
+// Function which builds the greedily optimized surface of a single layer
+bool BlockyMesher::meshLayer(const VoxelGrid& grid, Direction d, int layer, Surface& out) const {
+	out = BinaryMesher::meshLayer(grid, d, layer, bestOrientation ? BinaryMesher::bestOrientationSlice : BinaryMesher::greedySlice);
+	return true;
+}
+
+// Function which gets the variant of the mesher which keeps the best of every sweep orientation
+const Mesher* BlockyMesher::thorough() const {
+	static const BlockyMesher best(true);
+	return &best;
+}
+
+// Function which samples the density of every block in <grid> (indexed like the grid, missing neighbors are empty)
+std::vector<float> Mesher::sampleDensity(const VoxelGrid& grid){
+	// Look up the density of every state once
+	std::vector<float> stateDensity(grid.properties.size());
+	for(size_t s = 0; s < stateDensity.size(); s++)
+		stateDensity[s] = grid.properties[s].solid;
+
+	const int N = CHUNK_DIMENSIONS;
+	std::vector<float> out(VoxelGrid::SIZE * VoxelGrid::SIZE * VoxelGrid::SIZE, 0);
+	for(int x = -1; x <= N; x++)
+		for(int z = -1; z <= N; z++)
+			for(int y = -1; y <= N; y++){
+				BlockState state = grid.get(x, y, z);
+				if(state != VoxelGrid::NONE)
+					out[VoxelGrid::index(x, y, z)] = stateDensity[state];
+			}
+	return out;
+}
+
+// Function which gives the vertices of a smooth surface whose normal couldn't be found from the density the normal of the triangles around them
+void Mesher::fillMissingNormals(Surface& surf){
+	std::vector<bool> missing(surf.verts.size());
+	bool any = false;
+	for(size_t i = 0; i < surf.norms.size(); i++)
+		any |= missing[i] = surf.norms[i] == Vector3(0, 0, 0);
+	if(!any) return;
+
+	// Sum the normals of the triangles around each vertex (weighted by their area)
+	for(size_t i = 0; i + 2 < surf.indecies.size(); i += 3){
+		int a = surf.indecies[i], b = surf.indecies[i + 1], c = surf.indecies[i + 2];
+		Vector3 normal = (surf.verts[c] - surf.verts[a]).cross(surf.verts[b] - surf.verts[a]);
+		for(int v: {a, b, c})
+			if(missing[v]) surf.norms[v] += normal;
+	}
+	for(size_t i = 0; i < surf.norms.size(); i++)
+		if(missing[i] && surf.norms[i] != Vector3(0, 0, 0))
+			surf.norms[i].normalize();
+}
@@ -0,0 +1,83 @@
+#ifndef __MESHER_H__
+#define __MESHER_H__
+
+#include "../SurfFaceEdge.h"
+#include "VoxelGrid.h"
+
+/*
+	Interface of the algorithms which turn a VoxelGrid snapshot of a chunk into a
+	surface. The border of the grid is the padding copied from the chunk's
+	neighbors, so a mesher never has to look anything up in the ChunkMap. Meshers
+	keep all of their scratch memory local to a call, which lets a single shared
+	instance of each mesher be used by every worker thread at once. Surfaces are
+	built in world space like the rest of the meshing code.
+*/
+class Mesher {
+public:
+	// The available meshing algorithms
+	enum Type {
+		BLOCKY, // Greedily merged cube faces (see BinaryMesher)
+		SURFACE_NETS, // Smooth surface with one vertex per cell the surface passes through (see SurfaceNetsMesher)
+		MARCHING_CUBES, // Smooth surface with one vertex per edge the surface crosses (see MarchingCubesMesher)
+		POLYGON // Cube faces merged into polygons which are triangulated (see PolygonMesher)
+	};
+
+	virtual ~Mesher() {}
+	// Function which gets the shared instance of the mesher of the given <type>
+	static const Mesher* get(Type type);
+
+	// Function which gets the name of the mesher
+	virtual const char* getName() const = 0;
+	// Function which builds the surface of the chunk captured in <grid>
+	virtual Surface mesh(const VoxelGrid& grid) const = 0;
+	// Function which builds the surface of the chunk captured in <grid> split up by layer, returns false (leaving <out> untouched)
+	// if the mesher's surfaces can't be split into layers (so the whole chunk has to be remeshed whenever something changes)
+	virtual bool meshLayers(const VoxelGrid& grid, Chunk::LayerSurfaces& out) const { return false; }
+	// Function which builds the surface of the <layer>th layer facing direction <d> of the chunk captured in <grid> (see VoxelGrid::captureLayer),
+	// returns false (leaving <out> untouched) if the mesher's surfaces can't be split into layers
+	virtual bool meshLayer(const VoxelGrid& grid, Direction d, int layer, Surface& out) const { return false; }
+	// Function which determines if the surface depends on the blocks diagonally across the edges and corners of the chunk
+	// (if it does those neighbors have to be remeshed when the blocks change as well)
+	virtual bool readsDiagonals() const { return false; }
+	// Function which determines if every vertex the mesher places lies on a whole block coordinate
+	// (only then can the positions be stored as half floats without cracking the seams between chunks)
+	virtual bool integerPositions() const { return false; }
+	// Function which gets a slower variant of the mesher which builds cheaper surfaces, meant for chunks which are rarely remeshed
+	// (the mesher itself if it doesn't have one)
+	virtual const Mesher* thorough() const { return this; }
+
+protected:
+	// Density at which the smooth meshers place the surface (solid blocks have a density of 1, everything else 0)
+	static constexpr float ISO_LEVEL = .5;
+	// The corners at the ends of each edge of a cell, corner i is offset by (i & 1, i >> 1 & 1, i >> 2 & 1) from the cell's first corner,
+	// edges 0-3 run along x, 4-7 along y, and 8-11 along z
+	static const int CUBE_EDGES[12][2];
+	// Function which gets the offset of a corner of a cell from the cell's first corner
+	static Vector3 cornerOffset(int corner){ return Vector3(corner & 1, corner >> 1 & 1, corner >> 2 & 1); }
+	// Function which samples the density of every block in <grid> (indexed like the grid, missing neighbors are empty)
+	static std::vector<float> sampleDensity(const VoxelGrid& grid);
+	// Function which gets the world position of the density sample of block (0, 0, 0) (samples lie on the centers of the blocks)
+	static Vector3 sampleOrigin(const VoxelGrid& grid){
+		return grid.center - Vector3(CHUNK_DIMENSIONS / 2 - .5, CHUNK_DIMENSIONS / 2 - .5, CHUNK_DIMENSIONS / 2 - .5);
+	}
+	// Function which gives the vertices of a smooth surface whose normal couldn't be found from the density the normal of the triangles around them
+	static void fillMissingNormals(Surface& surf);
+};
+
+// Mesher which greedily merges the visible faces of the blocks into quads, if <bestOrientation> is set every slice is swept
+// from each corner along both axes and the sweep with the fewest quads is kept (see BinaryMesher::bestOrientationSlice)
+class BlockyMesher: public Mesher {
+public:
+	explicit BlockyMesher(bool bestOrientation = false) : bestOrientation(bestOrientation) {}
+	const char* getName() const override { return bestOrientation ? "blocky (best orientation)" : "blocky"; }
+	Surface mesh(const VoxelGrid& grid) const override;
+	bool meshLayers(const VoxelGrid& grid, Chunk::LayerSurfaces& out) const override;
+	bool meshLayer(const VoxelGrid& grid, Direction d, int layer, Surface& out) const override;
+	bool integerPositions() const override { return true; }
+	const Mesher* thorough() const override;
+
+protected:
+	bool bestOrientation;
+};
+
+#endif // __MESHER_H__
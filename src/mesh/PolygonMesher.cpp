@@ -0,0 +1,313 @@
+#include "PolygonMesher.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+typedef BinaryMesher::Row Row;
+
+// Corner of a cell in a slice, x runs along the slice's first axis and y along its second (see Surface::GreedyMeshCoplanar)
+struct Point {
+	int x, y;
+	bool operator==(const Point& o) const { return x == o.x && y == o.y; }
+};
+
+// Function which gets twice the signed area of the triangle (<a>, <b>, <c>), positive if it turns counter clockwise
+static inline int64_t cross(Point a, Point b, Point c){
+	return int64_t(b.x - a.x) * (c.y - a.y) - int64_t(b.y - a.y) * (c.x - a.x);
+}
+
+// Function which determines if <p> lies inside (or on the border of) the counter clockwise triangle (<a>, <b>, <c>)
+static inline bool insideTriangle(Point a, Point b, Point c, Point p){
+	return cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0;
+}
+
+// Function which determines if the segment from corner <i> of a counter clockwise <polygon> towards <target> starts out inside the polygon
+static bool locallyInside(const std::vector<Point>& polygon, size_t i, Point target){
+	size_t n = polygon.size();
+	Point u = polygon[(i + n - 1) % n], v = polygon[i], w = polygon[(i + 1) % n];
+	// At a convex corner the inside is the wedge between the edges, at a reflex corner it is everything outside of the opposite wedge
+	if(cross(u, v, w) >= 0)
+		return cross(v, w, target) >= 0 && cross(v, target, u) >= 0;
+	return !(cross(v, u, target) > 0 && cross(v, target, w) > 0);
+}
+
+// Function which joins a clockwise <hole> into the counter clockwise <polygon> surrounding it through a pair of bridge edges
+static void bridgeHole(std::vector<Point>& polygon, const std::vector<Point>& hole){
+	// The bridge starts at the corner of the hole furthest along x and runs along x to the first edge of the polygon it hits
+	size_t m = 0;
+	for(size_t i = 1; i < hole.size(); i++)
+		if(hole[i].x > hole[m].x || (hole[i].x == hole[m].x && hole[i].y > hole[m].y))
+			m = i;
+	Point M = hole[m];
+
+	size_t n = polygon.size();
+	double hitX = 1e30;
+	size_t hit = n;
+	for(size_t i = 0; i < n; i++){
+		Point a = polygon[i], b = polygon[(i + 1) % n];
+		// Edges on the right of the inside of a counter clockwise polygon run upwards
+		if(a.y > M.y || b.y < M.y || a.y == b.y) continue;
+		double x = a.x + double(M.y - a.y) * (b.x - a.x) / (b.y - a.y);
+		if(x >= M.x && x < hitX){
+			hitX = x;
+			// If the ray hits a corner the bridge goes straight to it, otherwise to the end of the edge furthest along x
+			hit = b.y == M.y && b.x == x ? (i + 1) % n : a.y == M.y && a.x == x ? i : a.x > b.x ? i : (i + 1) % n;
+		}
+	}
+	if(hit == n) return;
+
+	// If a reflex corner of the polygon lies between the ray and the chosen corner the bridge would cross the polygon,
+	// so the bridge goes to whichever such corner is closest in angle to the ray
+	Point I = {int(std::ceil(hitX)), M.y}, P = polygon[hit];
+	if(!(P.y == M.y && P.x == hitX)){
+		Point a = M, b = P.y < M.y ? P : I, c = P.y < M.y ? I : P;
+		if(cross(a, b, c) < 0) std::swap(b, c);
+		double bestTan = 1e30;
+		for(size_t i = 0; i < n; i++){
+			Point v = polygon[i];
+			if(v == P || v.x < M.x || !insideTriangle(a, b, c, v)) continue;
+			if(cross(polygon[(i + n - 1) % n], v, polygon[(i + 1) % n]) >= 0) continue;
+			double tan = v.x == M.x ? 1e30 : std::abs(v.y - M.y) / double(v.x - M.x);
+			if(tan < bestTan || (tan == bestTan && v.x < polygon[hit].x)){
+				bestTan = tan;
+				hit = i;
+			}
+		}
+	}
+
+	// The polygon can pass through the same point more than once (along earlier bridges), use the copy the bridge leaves inwards from
+	for(size_t i = 0; i < n; i++)
+		if(polygon[i] == polygon[hit] && locallyInside(polygon, i, M)){
+			hit = i;
+			break;
+		}
+
+	// Walk the polygon to the bridge, around the hole, and back over the bridge
+	std::vector<Point> joined;
+	joined.reserve(n + hole.size() + 2);
+	joined.insert(joined.end(), polygon.begin(), polygon.begin() + hit + 1);
+	joined.insert(joined.end(), hole.begin() + m, hole.end());
+	joined.insert(joined.end(), hole.begin(), hole.begin() + m + 1);
+	joined.insert(joined.end(), polygon.begin() + hit, polygon.end());
+	polygon.swap(joined);
+}
+
+// Function which triangulates a counter clockwise <polygon> (which may touch itself along bridges) by ear clipping,
+// the corners of each triangle are added to <triangles> as indices into <polygon>
+static void earClip(const std::vector<Point>& polygon, std::vector<int>& triangles){
+	size_t n = polygon.size();
+	std::vector<int> prev(n), next(n);
+	for(size_t i = 0; i < n; i++){
+		prev[i] = (i + n - 1) % n;
+		next[i] = (i + 1) % n;
+	}
+
+	size_t remaining = n;
+	// The number of corners checked since the last one was clipped
+	size_t stalled = 0;
+	int i = 0;
+	while(remaining > 2 && stalled < 2 * remaining){
+		int a = prev[i], c = next[i];
+		int64_t turn = cross(polygon[a], polygon[i], polygon[c]);
+		bool clip = turn == 0;
+		// A convex corner is an ear if no reflex corner lies inside of its triangle (convex corners can't be inside of an ear without a reflex
+		// one, and ignoring them lets ears touch the corners along bridges), if a whole lap found no ear any convex corner is taken
+		if(turn > 0){
+			clip = true;
+			if(stalled <= remaining)
+				for(int j = next[c]; j != a; j = next[j]){
+					Point p = polygon[j];
+					if(p == polygon[a] || p == polygon[i] || p == polygon[c] || cross(polygon[prev[j]], p, polygon[next[j]]) > 0) continue;
+					if(insideTriangle(polygon[a], polygon[i], polygon[c], p)){
+						clip = false;
+						break;
+					}
+				}
+		}
+		if(!clip){
+			i = next[i];
+			stalled++;
+			continue;
+		}
+
+		// Corners which don't turn are dropped without a triangle
+		if(turn > 0)
+			triangles.insert(triangles.end(), {a, i, c});
+		next[a] = c;
+		prev[c] = a;
+		remaining--;
+		stalled = 0;
+		// Removing the corner may have turned the one before it into an ear
+		i = a;
+	}
+}
+
+// Function which gets the position of a corner of the cells in a slice
+static Vector3 slicePoint(Direction d, Vector3 center, Point p){
+	float half = CHUNK_DIMENSIONS / 2;
+	float y = p.x - half, x = p.y - half;
+	switch(axisOf(d)){
+	case 0: return center + Vector3(0, y, x);
+	case 1: return center + Vector3(y, 0, x);
+	default: return center + Vector3(y, x, 0);
+	}
+}
+
+// Function which merges the faces in the rows of a slice into polygons and triangulates them (a BinaryMesher::SliceMerger)
+void PolygonMesher::polygonSlice(Row* rows, Direction d, Vector3 center, int blockID, Surface& out){
+	const int N = CHUNK_DIMENSIONS, CORNERS = N + 1;
+	auto set = [rows, N](int x, int y){ return x >= 0 && x < N && y >= 0 && y < N && (rows[x] >> y & 1); };
+	Row any = 0;
+	for(int x = 0; x < N; x++)
+		any |= rows[x];
+	if(!any) return;
+
+	// Group the faces into regions of faces which share edges
+	int parent[N * N];
+	for(int c = 0; c < N * N; c++)
+		parent[c] = c;
+	auto find = [&parent](int c){
+		while(parent[c] != c)
+			c = parent[c] = parent[parent[c]];
+		return c;
+	};
+	for(int x = 0; x < N; x++)
+		for(int y = 0; y < N; y++){
+			if(!set(x, y)) continue;
+			if(set(x + 1, y)) parent[find((x + 1) * N + y)] = find(x * N + y);
+			if(set(x, y + 1)) parent[find(x * N + y + 1)] = find(x * N + y);
+		}
+
+	// Find the edges on the border of the faces, running counter clockwise around the faces they belong to
+	struct Edge { Point from, to; int cell; bool used; };
+	// A cell has at most four edges
+	Edge edges[4 * N * N];
+	int edgeCount = 0;
+	// The edges leaving each corner (two edges leave the corners where faces only touch diagonally)
+	int leaving[CORNERS * CORNERS * 2];
+	std::fill(leaving, leaving + CORNERS * CORNERS * 2, -1);
+	auto addEdge = [&](Point from, Point to, int cell){
+		int* slot = &leaving[(from.x * CORNERS + from.y) * 2];
+		slot[slot[0] >= 0] = edgeCount;
+		edges[edgeCount++] = {from, to, cell, false};
+	};
+	for(int x = 0; x < N; x++)
+		for(int y = 0; y < N; y++){
+			if(!set(x, y)) continue;
+			int cell = x * N + y;
+			if(!set(x, y - 1)) addEdge({x, y}, {x + 1, y}, cell);
+			if(!set(x + 1, y)) addEdge({x + 1, y}, {x + 1, y + 1}, cell);
+			if(!set(x, y + 1)) addEdge({x + 1, y + 1}, {x, y + 1}, cell);
+			if(!set(x - 1, y)) addEdge({x, y + 1}, {x, y}, cell);
+		}
+
+	// Trace the edges into loops, the outer border of each region runs counter clockwise and its holes clockwise
+	struct Loop { std::vector<Point> points; int region; int64_t area; };
+	std::vector<Loop> loops;
+	for(int start = 0; start < edgeCount; start++){
+		if(edges[start].used) continue;
+		std::vector<Point> points;
+		int e = start;
+		do {
+			edges[e].used = true;
+			points.push_back(edges[e].from);
+			const int* slot = &leaving[(edges[e].to.x * CORNERS + edges[e].to.y) * 2];
+			int next = slot[0];
+			// Where faces touch diagonally turn left, which keeps following the same face and keeps every loop simple
+			if(slot[1] >= 0 && cross(edges[e].from, edges[e].to, edges[slot[1]].to) > 0)
+				next = slot[1];
+			e = next;
+		} while(e != start);
+
+		// Drop the corners which don't turn
+		Loop loop = {{}, find(edges[start].cell), 0};
+		size_t n = points.size();
+		for(size_t i = 0; i < n; i++)
+			if(cross(points[(i + n - 1) % n], points[i], points[(i + 1) % n]) != 0)
+				loop.points.push_back(points[i]);
+		for(size_t i = 0; i < loop.points.size(); i++)
+			loop.area += cross({0, 0}, loop.points[i], loop.points[(i + 1) % loop.points.size()]);
+		loops.push_back(std::move(loop));
+	}
+
+	// Merge the faces into quads as well (this clears the rows), every quad lies within a single region
+	BinaryMesher::Quad quads[N * N];
+	int quadCount = BinaryMesher::greedyQuads(rows, quads);
+
+	// Rectilinear polygons only take fewer triangles than their quads where the greedy quads aren't the fewest rectangles the region
+	// can be split into, so every region keeps whichever takes fewer triangles (a region whose borders have n corners and which has
+	// h holes takes n + 2h - 2 triangles, ties go to the polygon since it shares its vertices)
+	int quadTriangles[N * N] = {}, polygonTriangles[N * N] = {};
+	for(int q = 0; q < quadCount; q++)
+		quadTriangles[find(quads[q].first * N + quads[q].second)] += 2;
+	for(const Loop& loop: loops)
+		polygonTriangles[loop.region] += loop.points.size() + (loop.area < 0 ? 2 : -2);
+	auto polygonal = [&](int region){ return polygonTriangles[region] <= quadTriangles[region]; };
+
+	for(int q = 0; q < quadCount; q++)
+		if(!polygonal(find(quads[q].first * N + quads[q].second)))
+			out += Surface::greedyQuad(d, center, quads[q].first, quads[q].second, quads[q].h, quads[q].w, blockID, N);
+
+	Vector3 normal = Surface::greedyQuad(d, center, 0, 0, 1, 1, blockID, N).normal;
+	// Greedy quads facing these directions are reversed, so their triangles have to turn the other way
+	bool reversed = d == BOTTOM || d == NORTH || d == EAST;
+	// Index of the vertex at each corner of the slice (the polygons of the slice share their corners)
+	int vertexAt[CORNERS * CORNERS];
+	std::fill(vertexAt, vertexAt + CORNERS * CORNERS, -1);
+	auto vertex = [&](Point p){
+		int& index = vertexAt[p.x * CORNERS + p.y];
+		if(index < 0){
+			index = out.verts.size();
+			out.verts.push_back(slicePoint(d, center, p));
+			out.norms.push_back(normal);
+			out.uvs.push_back(Surface::layerUV(d, p.x, p.y, N));
+		}
+		return index;
+	};
+
+	// Join the holes of the remaining regions into their outer borders and triangulate them
+	std::vector<int> triangles;
+	for(Loop& outer: loops){
+		if(outer.area <= 0 || !polygonal(outer.region)) continue;
+		std::vector<const Loop*> holes;
+		for(const Loop& hole: loops)
+			if(hole.area < 0 && hole.region == outer.region)
+				holes.push_back(&hole);
+		// Holes are bridged furthest along x first so that later bridges can't cross earlier ones
+		auto furthest = [](const Loop* l){
+			int x = l->points[0].x;
+			for(const Point& p: l->points) x = std::max(x, p.x);
+			return x;
+		};
+		std::sort(holes.begin(), holes.end(), [&furthest](const Loop* a, const Loop* b){ return furthest(a) > furthest(b); });
+		for(const Loop* hole: holes)
+			bridgeHole(outer.points, hole->points);
+
+		triangles.clear();
+		earClip(outer.points, triangles);
+		for(size_t t = 0; t + 2 < triangles.size(); t += 3){
+			int a = vertex(outer.points[triangles[t]]), b = vertex(outer.points[triangles[t + 1]]), c = vertex(outer.points[triangles[t + 2]]);
+			if(reversed) std::swap(b, c);
+			out.indecies.insert(out.indecies.end(), {a, b, c});
+		}
+	}
+}
+
+// Function which builds the polygon optimized surface of the chunk captured in <grid>
+Surface PolygonMesher::mesh(const VoxelGrid& grid) const {
+	return BinaryMesher::mesh(grid, polygonSlice);
+}
+
+// Function which builds the polygon optimized surface of the chunk captured in <grid> split up by layer
+bool PolygonMesher::meshLayers(const VoxelGrid& grid, Chunk::LayerSurfaces& out) const {
+	BinaryMesher::mesh(grid, out, polygonSlice);
+	return true;
+}
+
+// Function which builds the polygon optimized surface of a single layer
+bool PolygonMesher::meshLayer(const VoxelGrid& grid, Direction d, int layer, Surface& out) const {
+	out = BinaryMesher::meshLayer(grid, d, layer, polygonSlice);
+	return true;
+}
@@ -0,0 +1,39 @@
+#ifndef __POLYGON_MESHER_H__
+#define __POLYGON_MESHER_H__
+
+#include "Mesher.h"
+#include "BinaryMesher.h"
+
+/*
+	Mesher which merges the visible faces of each block ID in a slice into
+	polygons instead of rectangles. The faces are found with the same bitmasks as
+	BinaryMesher, then the cells of the slice are grouped into regions with a
+	union-find and the border of the faces is traced into loops through a table of
+	the edges leaving every corner (outer borders run counter clockwise, holes
+	clockwise). Corners which don't turn are dropped, the holes of each region are
+	bridged into its outer border, and the resulting polygon is triangulated by
+	ear clipping. A region with n corners and h holes takes n + 2h - 2 triangles
+	no matter how many rectangles it would have been split into, which only beats
+	the greedy quads where they aren't the fewest rectangles covering the region,
+	so each region keeps whichever of the two takes fewer triangles. Dropping the
+	straight corners leaves T-junctions wherever a region borders a region of
+	another block ID or one which kept its greedy quads (like the greedy quads
+	themselves), so the surface is only watertight up to those junctions.
+*/
+class PolygonMesher: public Mesher {
+public:
+	const char* getName() const override { return "polygon"; }
+	// Function which builds the polygon optimized surface of the chunk captured in <grid>
+	Surface mesh(const VoxelGrid& grid) const override;
+	// Function which builds the polygon optimized surface of the chunk captured in <grid> split up by layer
+	bool meshLayers(const VoxelGrid& grid, Chunk::LayerSurfaces& out) const override;
+	// Function which builds the polygon optimized surface of a single layer
+	bool meshLayer(const VoxelGrid& grid, Direction d, int layer, Surface& out) const override;
+	// Polygon corners are block corners, so they always lie on whole coordinates
+	bool integerPositions() const override { return true; }
+
+	// Function which merges the faces in the rows of a slice into polygons and triangulates them (a BinaryMesher::SliceMerger)
+	static void polygonSlice(BinaryMesher::Row* rows, Direction d, Vector3 center, int blockID, Surface& out);
+};
+
+#endif // __POLYGON_MESHER_H__
@@ -0,0 +1,103 @@
+#include "SurfaceNetsMesher.h"
+
+#include <vector>
+
+// Function which gets the lookup table of the edges of a cell crossed by the surface, indexed by which corners are solid (bit i is edge i)
+const uint16_t* SurfaceNetsMesher::crossedEdges(){
+	struct Table {
+		uint16_t edges[256];
+		Table(){
+			for(int mask = 0; mask < 256; mask++){
+				edges[mask] = 0;
+				for(int e = 0; e < 12; e++)
+					if((mask >> CUBE_EDGES[e][0] & 1) != (mask >> CUBE_EDGES[e][1] & 1))
+						edges[mask] |= 1 << e;
+			}
+		}
+	};
+	// Built once, the first time any thread needs it
+	static const Table table;
+	return table.edges;
+}
+
+// Function which builds the smooth surface of the chunk captured in <grid>
+Surface SurfaceNetsMesher::mesh(const VoxelGrid& grid) const {
+	const int N = CHUNK_DIMENSIONS;
+	const uint16_t* edgeTable = crossedEdges();
+	std::vector<float> density = sampleDensity(grid);
+	Vector3 origin = sampleOrigin(grid);
+	Surface out;
+
+	// Index of the vertex in each cell, cells run from -1 to N - 1 along each axis (cell c lies between the samples c and c + 1),
+	// -1 if the surface doesn't pass through the cell
+	const int CELLS = N + 1;
+	std::vector<int> cellVertex(CELLS * CELLS * CELLS, -1);
+	auto cellIndex = [CELLS](int x, int y, int z){ return ((x + 1) * CELLS + (z + 1)) * CELLS + (y + 1); };
+
+	// Place a vertex in every cell the surface passes through
+	for(int x = -1; x < N; x++)
+		for(int z = -1; z < N; z++)
+			for(int y = -1; y < N; y++){
+				float d[8];
+				int mask = 0;
+				for(int i = 0; i < 8; i++){
+					d[i] = density[VoxelGrid::index(x + (i & 1), y + (i >> 1 & 1), z + (i >> 2 & 1))];
+					mask |= (d[i] >= ISO_LEVEL) << i;
+				}
+				uint16_t edges = edgeTable[mask];
+				if(!edges) continue;
+
+				// The vertex sits at the average of the points where the surface crosses the cell's edges
+				Vector3 sum(0, 0, 0);
+				int crossings = 0;
+				for(int e = 0; e < 12; e++)
+					if(edges >> e & 1){
+						int a = CUBE_EDGES[e][0], b = CUBE_EDGES[e][1];
+						float t = (ISO_LEVEL - d[a]) / (d[b] - d[a]);
+						sum += cornerOffset(a).linear_interpolate(cornerOffset(b), t);
+						crossings++;
+					}
+				// The density increases into the solid, so the normal points down its gradient (found from the cell's corners)
+				Vector3 gradient(d[1] - d[0] + d[3] - d[2] + d[5] - d[4] + d[7] - d[6],
+					d[2] - d[0] + d[3] - d[1] + d[6] - d[4] + d[7] - d[5],
+					d[4] - d[0] + d[5] - d[1] + d[6] - d[2] + d[7] - d[3]);
+
+				cellVertex[cellIndex(x, y, z)] = out.verts.size();
+				out.verts.push_back(origin + Vector3(x, y, z) + sum / crossings);
+				out.norms.push_back(gradient == Vector3(0, 0, 0) ? gradient : -gradient.normalized());
+			}
+
+	// Join the four cells around every edge the surface crosses into a quad, the chunk owns the edges starting at its own samples
+	for(int x = 0; x < N; x++)
+		for(int z = 0; z < N; z++)
+			for(int y = 0; y < N; y++){
+				int s[3] = {x, y, z};
+				bool solid = density[VoxelGrid::index(x, y, z)] >= ISO_LEVEL;
+				for(int axis = 0; axis < 3; axis++){
+					int n[3] = {x, y, z};
+					n[axis]++;
+					if(solid == (density[VoxelGrid::index(n[0], n[1], n[2])] >= ISO_LEVEL)) continue;
+
+					// The cells around the edge, going counter clockwise around the axis (so the quad faces down the axis)
+					int u = (axis + 1) % 3, v = (axis + 2) % 3;
+					int quad[4];
+					for(int corner = 0; corner < 4; corner++){
+						int c[3] = {s[0], s[1], s[2]};
+						c[u] -= corner == 0 || corner == 3;
+						c[v] -= corner == 0 || corner == 1;
+						quad[corner] = cellVertex[cellIndex(c[0], c[1], c[2])];
+					}
+					// If the solid side is at the start of the edge the quad faces up the axis instead
+					if(solid) std::swap(quad[1], quad[3]);
+
+					// Split the quad along its shorter diagonal
+					if(out.verts[quad[0]].distance_squared_to(out.verts[quad[2]]) <= out.verts[quad[1]].distance_squared_to(out.verts[quad[3]]))
+						out.indecies.insert(out.indecies.end(), {quad[0], quad[1], quad[2], quad[2], quad[3], quad[0]});
+					else
+						out.indecies.insert(out.indecies.end(), {quad[0], quad[1], quad[3], quad[1], quad[2], quad[3]});
+				}
+			}
+
+	fillMissingNormals(out);
+	return out;
+}
@@ -0,0 +1,31 @@
+#ifndef __SURFACE_NETS_MESHER_H__
+#define __SURFACE_NETS_MESHER_H__
+
+#include <cstdint>
+
+#include "Mesher.h"
+
+/*
+	Smooth mesher which places a single vertex inside every cell (the cube between
+	eight neighboring block centers) that the surface passes through, at the average
+	of the points where the surface crosses the cell's edges. Every edge the surface
+	crosses becomes a quad joining the vertices of the four cells around it, so the
+	vertices are shared without any welding. A chunk owns the edges starting at its
+	own blocks, the cells on its negative border are meshed by both chunks and come
+	out the same, which keeps neighboring chunks sealed. Samples are taken at every
+	block, at lower levels of detail the blocks of the grid already hold the coarser
+	voxels so only the shape gets coarser.
+*/
+class SurfaceNetsMesher: public Mesher {
+public:
+	const char* getName() const override { return "surface nets"; }
+	// Function which builds the smooth surface of the chunk captured in <grid>
+	Surface mesh(const VoxelGrid& grid) const override;
+	bool readsDiagonals() const override { return true; }
+
+protected:
+	// Function which gets the lookup table of the edges of a cell crossed by the surface, indexed by which corners are solid (bit i is edge i)
+	static const uint16_t* crossedEdges();
+};
+
+#endif // __SURFACE_NETS_MESHER_H__
@@ -0,0 +1,84 @@
+#include "VoxelGrid.h"
+
+#include <algorithm>
+
+#include "../world/ChunkMap.h"
+
+const BlockState VoxelGrid::NONE;
+
+// Function which captures the blocks of <chunk> and the blocks of its neighbors touching it (across its faces, edges, and corners)
+// at the requested <levelOfDetail>
+void VoxelGrid::capture(Chunk& chunk, int levelOfDetail /*= 0*/){
+	center = chunk.center;
+	this->levelOfDetail = levelOfDetail;
+	properties = BlockDatabase::getSingleton()->stateProperties;
+	std::fill(states.begin(), states.end(), NONE);
+
+	// Fill the inside of the grid, voxels above the block level cover a cube of blocks
+	chunk.ensureOctree();
+	Vector3 corner = chunk.center - Vector3(CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS / 2);
+	chunk.iterate(levelOfDetail, [this, corner](VoxelInstance* v, int){
+		int size = 1 << v->level;
+		Vector3 min = v->center - corner - Vector3(size / 2.0, size / 2.0, size / 2.0);
+		for(int x = min.x; x < min.x + size; x++)
+			for(int z = min.z; z < min.z + size; z++)
+				for(int y = min.y; y < min.y + size; y++)
+					set(x, y, z, v->blockState);
+	});
+
+	// Copy the layer of blocks touching each face of the chunk from its neighbors, at the level of detail each neighbor is meshed at
+	// (so faces are only culled against what the neighbor actually shows and no cracks open between chunks at different levels)
+	if(!chunk.map) return;
+	ivec3 origin = chunk.getCorner();
+	auto sample = [this, &chunk, origin](int x, int y, int z){
+		VoxelInstance* v = chunk.map->findDisplayed(origin + ivec3(x, y, z));
+		set(x, y, z, v ? v->blockState : NONE);
+	};
+	for(int a = 0; a < CHUNK_DIMENSIONS; a++)
+		for(int b = 0; b < CHUNK_DIMENSIONS; b++){
+			sample(-1, a, b);
+			sample(CHUNK_DIMENSIONS, a, b);
+			sample(a, -1, b);
+			sample(a, CHUNK_DIMENSIONS, b);
+			sample(a, b, -1);
+			sample(a, b, CHUNK_DIMENSIONS);
+		}
+	// The smooth meshers also look at the blocks diagonally across the edges and corners of the chunk
+	for(int a: {-1, CHUNK_DIMENSIONS})
+		for(int b: {-1, CHUNK_DIMENSIONS}){
+			for(int i = 0; i < CHUNK_DIMENSIONS; i++){
+				sample(i, a, b);
+				sample(a, i, b);
+				sample(a, b, i);
+			}
+			sample(a, b, -1);
+			sample(a, b, CHUNK_DIMENSIONS);
+		}
+}
+
+// Function which captures only the blocks in the <layer>th layer of <chunk> facing direction <d> and the blocks touching their faces
+// (enough to mesh that layer, the rest of the grid is left empty)
+void VoxelGrid::captureLayer(Chunk& chunk, Direction d, int layer, int levelOfDetail /*= 0*/){
+	center = chunk.center;
+	this->levelOfDetail = levelOfDetail;
+	properties = BlockDatabase::getSingleton()->stateProperties;
+	std::fill(states.begin(), states.end(), NONE);
+
+	chunk.ensureOctree();
+	ivec3 origin = chunk.getCorner();
+	int axis = axisOf(d);
+	// Position of the layer along the axis and of the blocks its faces touch
+	int i = isPositive(d) ? CHUNK_DIMENSIONS - 1 - layer : layer, beside = isPositive(d) ? i + 1 : i - 1;
+	for(int along: {i, beside})
+		for(int a = 0; a < CHUNK_DIMENSIONS; a++)
+			for(int b = 0; b < CHUNK_DIMENSIONS; b++){
+				ivec3 local = axis == 0 ? ivec3(along, a, b) : axis == 1 ? ivec3(a, along, b) : ivec3(a, b, along);
+				// Blocks outside of the chunk come from its neighbors (at the level of detail they are meshed at)
+				VoxelInstance* v;
+				if(along >= 0 && along < CHUNK_DIMENSIONS)
+					v = chunk.find(levelOfDetail, local);
+				else
+					v = chunk.map ? chunk.map->findDisplayed(origin + local) : nullptr;
+				set(local.x, local.y, local.z, v ? v->blockState : NONE);
+			}
+}
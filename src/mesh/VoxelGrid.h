@@ -0,0 +1,50 @@
+#ifndef __VOXEL_GRID_H__
+#define __VOXEL_GRID_H__
+#include <vector>
+#include <cstddef>
+
+#include "../world/Chunk.h"
+
+/*
+	Dense snapshot of the blocks in a chunk plus a one block border copied from
+	its neighbors. Meshers read from this copy instead of walking the octree, the
+	border lets them decide the visibility of faces on the edge of the chunk
+	without looking anything up in the ChunkMap. The properties of the block
+	states are copied along with the blocks, so since the grid holds no pointers
+	into the world or the BlockDatabase it is safe to hand to other threads.
+*/
+class VoxelGrid {
+public:
+	// The number of blocks along each side of the grid (the chunk plus a border on each side)
+	static const int SIZE = CHUNK_DIMENSIONS + 2;
+	// State of border blocks whose chunk isn't loaded (treated as empty space)
+	static const BlockState NONE = 0xFFFF;
+
+	// Center of the chunk the grid was captured from
+	Vector3 center = {0, 0, 0};
+	// The octree level the grid was captured at (every block holds the state of the voxel of that level containing it)
+	int levelOfDetail = 0;
+	// The properties of every block state (indexed by state), copied from the BlockDatabase when the grid is captured
+	std::vector<StateProperties> properties;
+
+	VoxelGrid() : states(SIZE * SIZE * SIZE, NONE) {}
+
+	// Function which captures the blocks of <chunk> and the blocks of its neighbors touching it (across its faces, edges, and corners)
+	// at the requested <levelOfDetail>
+	void capture(Chunk& chunk, int levelOfDetail = 0);
+	// Function which captures only the blocks in the <layer>th layer of <chunk> facing direction <d> and the blocks touching their faces
+	// (enough to mesh that layer, the rest of the grid is left empty)
+	void captureLayer(Chunk& chunk, Direction d, int layer, int levelOfDetail = 0);
+
+	// Functions which get/set the state of the block at the provided chunk-local block coordinates (-1 to CHUNK_DIMENSIONS inclusive)
+	BlockState get(int x, int y, int z) const { return states[index(x, y, z)]; }
+	void set(int x, int y, int z, BlockState state){ states[index(x, y, z)] = state; }
+
+	// Function which gets the index of a block in the grid (x major, y minor like Chunk::blockIndex)
+	static size_t index(int x, int y, int z){ return ((x + 1) * SIZE + (z + 1)) * SIZE + (y + 1); }
+
+protected:
+	std::vector<BlockState> states;
+};
+
+#endif // __VOXEL_GRID_H__
@@ -1,46 +1,19 @@
 #include "Chunk.h"
 
 #include <cmath>
-#include <map>
 #include <thread>
 
 #include "SurfaceTool.hpp"
 
 #include "../SurfFaceEdge.h"
+#include "../mesh/Mesher.h"
 #include "ChunkMap.h"
 
-#include "../timer.h"
-
 /*------------------------------------------------------------------------------
         VoxelInstance
 ------------------------------------------------------------------------------*/
-
-// Copy constructor
-VoxelInstance::VoxelInstance(VoxelInstance& origin){
-    blockData = BlockDatabase::getSingleton()->getBlock(origin.blockData->blockID);
-    // Make sure the copy has any special values set
-    *blockData = *origin.blockData;
-
-    flags = origin.flags;
-    level = origin.level;
-    center = origin.center;
-    subVoxels = origin.subVoxels;
-    //parent = origin.parent;
-    map = origin.map;
-}
-
-// Move constructor
-VoxelInstance::VoxelInstance(VoxelInstance&& origin){
-    blockData = origin.blockData;
-    origin.blockData = nullptr;
-
-    flags = origin.flags;
-    level = origin.level;
-    center = origin.center;
-    subVoxels = origin.subVoxels;
-    //parent = origin.parent;
-    map = origin.map;
-}
+// Table mapping Morton child indices (xBit | yBit << 1 | zBit << 2) to the order of subVoxels (see calculateCenters)
+static const int mortonToSubVoxel[8] = {6, 5, 2, 1, 7, 4, 3, 0};
 
 // Function which recursiveley sets up an octree of blocks
 void VoxelInstance::init(int level /*= SUBCHUNK_LEVELS*/, bool originalCall /*= true*/){
@@ -48,18 +21,15 @@ void VoxelInstance::init(int level /*= SUBCHUNK_LEVELS*/, bool originalCall /*=
 
     // If there is data to initalize and we aren't dealing with leaf nodes...
     if(level > 0){
-        subVoxels = new VoxelInstance [8]; // Create the next sublevels
+        allocateSubVoxels(); // Create the next sublevels
 
         // Distribute the blocks over the child sublevels
-        for(int i = 0; i < 8; i++){
-            subVoxels[i].map = map;
-
+        for(int i = 0; i < 8; i++)
             //subVoxels[i].parent = this; // Mark this sublevel as the parent of the child sublevels
             subVoxels[i].init(level - 1, false);
-        }
     }
 	// load an air block
-	blockData = BlockDatabase::getSingleton()->getBlock(Blocks::AIR);
+	blockState = BlockDatabase::getSingleton()->getDefaultState(Blocks::AIR);
 
     #warning not working?
     // If this was the original call recalculate
@@ -69,57 +39,30 @@ void VoxelInstance::init(int level /*= SUBCHUNK_LEVELS*/, bool originalCall /*=
 
 // Function which merges sublevels containing all of the same blockID into the same level
 bool VoxelInstance::prune(){
-    // Variable which ensures that small data changes not large enouph to change the mathematical
-    // mode of a sublevel don't get pruned
-    bool canPrune = true;
-    if(level > 1 && subVoxels)
-        for(size_t i = 0; i < 8; i++)
-            if(!subVoxels[i].prune())
-                canPrune = false;
-
-    size_t count = 0;	// Number of times the most common blockID appears in the sublevels
-    bool unpruneableFeatures = false; // Variable tracking if there are any unprunebale features
-    if(subVoxels){ // Make sure there are sublevels before finding the mode of the sublevels
-        struct CountHolder{
-                size_t count;
-                BlockData* d;
-        };
-        std::map<Identifier, CountHolder> m; // Map used to sort blockIDs
-        // Store the blockIDs sorted by occurence in a map
-        for(size_t i = 0; i < 8; i++) {
-            Identifier key = subVoxels[i].blockData->blockID;
-            std::map<Identifier, CountHolder>::iterator it = m.find(key);
-            if(it == m.end())
-                m.insert(std::make_pair(key, (CountHolder){1, subVoxels[i].blockData}));
-            else
-                it->second.count++;
-
-            // If this subVoxels is unpruneable, mark that we can't prune
-            unpruneableFeatures = unpruneableFeatures || subVoxels[i].blockData->hasUnprunableFeature();
-        }
-        // Find the most common blockID in the sublevels and store it as this level's blockID
-        Identifier finalID; // Variable storing the blockID which appears most
-        BlockData* finalData;
-        for(auto& it: m)
-            if(it.second.count > count) {
-                count = it.second.count;
-                finalID = it.first;
-                finalData = it.second.d;
-            }
-        if(blockData) delete blockData;
-        // Make sure block data is the correct type
-        blockData = BlockDatabase::getSingleton()->getBlock(finalID);
-        *blockData = *finalData; // TODO: Overload assignment opperator in BlockData if issues emerge
-    } else
-        return true; // If we have already pruned this branch we are safe to prune higher
+    // If we have already pruned this branch we are safe to prune higher
+    if(!subVoxels) return true;
+
+    // Prune the sublevels first so that merge only has to look at our direct children
+    for(size_t i = 0; i < 8; i++)
+        subVoxels[i].prune();
+    // Find the mode of the sublevels, and remove them if they are all the same leaf
+    return merge();
+}
 
-    // If the sublevels all have the same blockID, they can be removed
-    if(count == 8 && canPrune){
-        delete [] subVoxels;
-        subVoxels = nullptr;
-        return !unpruneableFeatures; // We are safe to prune higher up (assuming no unprunable features)
+// Function which builds this branch bottom up from a dense array of block states (indexed by Chunk::blockIndex),
+// <x, y, z> are the chunk-local coordinates of this voxel's minimum corner. Uniform branches are merged as soon as
+// they are built (returning their nodes to the arena) so the full tree is never allocated
+void VoxelInstance::build(const BlockState* blocks, int x /*= 0*/, int y /*= 0*/, int z /*= 0*/){
+    if(level == BLOCK_LEVEL){
+        blockState = blocks[Chunk::blockIndex(x, y, z)];
+        return;
     }
-    return false; // We are not safe to prune higher up
+
+    if(!subVoxels) allocateSubVoxels();
+    int half = 1 << (level - 1);
+    for(int m = 0; m < 8; m++)
+        subVoxels[mortonToSubVoxel[m]].build(blocks, x + (m & 1) * half, y + ((m >> 1) & 1) * half, z + ((m >> 2) & 1) * half);
+    merge();
 }
 
 // Function which takes a pruned tree and rebuilds the lower levels of the tree down to the block level
@@ -127,19 +70,12 @@ bool VoxelInstance::prune(){
 void VoxelInstance::unprune(bool originalCall /*= true*/){
     // If we don't have children and we aren't at the block level
     if(level > 0 && !subVoxels){
-        subVoxels = new VoxelInstance [8]; // Create the next sublevels
+        allocateSubVoxels(); // Create the next sublevels
 
-        // Pass down the block data to all the new children and unprune them
+        // Pass down the block state to all the new children and unprune them
         for(int i = 0; i < 8; i++){
             //subVoxels[i].parent = this;
-            subVoxels[i].map = map;
-            subVoxels[i].level = level - 1;
-
-            if(subVoxels[i].blockData) delete subVoxels[i].blockData;
-            // Make sure block data is the correct type
-            subVoxels[i].blockData = BlockDatabase::getSingleton()->getBlock(blockData->blockID);
-            *subVoxels[i].blockData = *blockData;
-
+            subVoxels[i].blockState = blockState;
             subVoxels[i].unprune(false);
         }
     // If we do have children and we aren't at the block level
@@ -153,6 +89,102 @@ void VoxelInstance::unprune(bool originalCall /*= true*/){
         recalculate();
 }
 
+// Function which splits a leaf into 8 subVoxels with the same state (only one level is created)
+void VoxelInstance::split(){
+    allocateSubVoxels();
+    for(int i = 0; i < 8; i++)
+        subVoxels[i].blockState = blockState;
+    calculateCenters();
+}
+
+// Function which merges the subVoxels if they are uniform leaves (otherwise updates this voxel's state to their mode),
+// only this level is looked at so the subVoxels should already be merged
+bool VoxelInstance::merge(){
+    if(!subVoxels) return true;
+
+    // Count how many times each state appears (fixed size, there are only 8 children)
+    BlockState states[8];
+    int counts[8], unique = 0;
+    bool allLeaves = true;
+    for(int c = 0; c < 8; c++){
+        allLeaves = allLeaves && !subVoxels[c].subVoxels;
+        int i = 0;
+        while(i < unique && states[i] != subVoxels[c].blockState) i++;
+        if(i == unique){
+            states[unique] = subVoxels[c].blockState;
+            counts[unique++] = 0;
+        }
+        counts[i]++;
+    }
+
+    // This voxel takes on the most common state of its children
+    int mode = 0;
+    for(int i = 1; i < unique; i++)
+        if(counts[i] > counts[mode])
+            mode = i;
+    blockState = states[mode];
+
+    // If all of the children are the same leaf... this voxel can become a leaf
+    // (blocks with unprunable features are only merged at the block level)
+    if(allLeaves && unique == 1 && (level == 1 || !BlockDatabase::getSingleton()->isUnprunable(blockState))){
+        freeSubVoxels();
+        return true;
+    }
+    return false;
+}
+
+// Function which creates the next sublevel (from the arena if this instance has one)
+void VoxelInstance::allocateSubVoxels(){
+    if(arena)
+        subVoxels = arena->allocate();
+    else
+        subVoxels = new VoxelInstance [8];
+
+    // Pass down the information every child needs
+    for(int i = 0; i < 8; i++){
+        subVoxels[i].map = map;
+        subVoxels[i].level = level - 1;
+    }
+}
+
+// Function which removes the next sublevel (returning it to the arena if this instance has one)
+void VoxelInstance::freeSubVoxels(){
+    if(arena)
+        arena->release(subVoxels);
+    else
+        delete [] subVoxels;
+    subVoxels = nullptr;
+}
+
+// Function which copies this branch into a linear octree (<index> is the node in <tree> representing this instance)
+void VoxelInstance::toLinear(LinearOctree& tree, uint32_t index /*= 0*/) const {
+    if(index == 0) tree.reset(level);
+    tree[index] = {blockState, level, (unsigned char) flags, 0};
+    if(!subVoxels) return;
+
+    uint32_t first = tree.size();
+    tree.nodes.resize(first + 8);
+    tree[index].children = first;
+    for(int m = 0; m < 8; m++)
+        subVoxels[mortonToSubVoxel[m]].toLinear(tree, first + m);
+}
+
+// Function which rebuilds this branch from a linear octree (centers must be recalculated afterwords)
+void VoxelInstance::fromLinear(const LinearOctree& tree, uint32_t index /*= 0*/){
+    const LinearOctree::Node& node = tree[index];
+    blockState = node.state;
+    level = node.level;
+    flags = node.flags;
+
+    if(node.isLeaf()){
+        if(subVoxels) freeSubVoxels();
+        return;
+    }
+    if(!subVoxels) allocateSubVoxels();
+    for(int m = 0; m < 8; m++)
+        subVoxels[mortonToSubVoxel[m]].fromLinear(tree, node.children + m);
+}
+
 // Function which given an arbitrary point in 3D space within the voxel
 // finds the subvoxel of the requested <lvl> which contains the point
 VoxelInstance* VoxelInstance::find(int lvl, Vector3& position){
@@ -175,6 +207,17 @@ VoxelInstance* VoxelInstance::find(int lvl, Vector3& position){
     return nullptr;
 }
 
+// Function which finds the subvoxel of the requested <lvl> containing the block at the provided chunk-local block coordinates,
+// the child at each level is picked directly from the coordinate's bits
+VoxelInstance* VoxelInstance::find(int lvl, const ivec3& position){
+    VoxelInstance* v = this;
+    while(v->level > lvl && v->subVoxels){
+        int bit = v->level - 1;
+        v = &v->subVoxels[mortonToSubVoxel[((position.x >> bit) & 1) | (((position.y >> bit) & 1) << 1) | (((position.z >> bit) & 1) << 2)]];
+    }
+    return v;
+}
+
 // Function which determines if an arbitrary point in space is within this voxel
 bool VoxelInstance::within(Vector3& position){
     // Calculate the "radius" of the cube based on its level
@@ -195,79 +238,54 @@ Face VoxelInstance::getFace(Direction d){
         return Face(center + Vector3(-bounds, bounds, bounds),
             center + Vector3(bounds, bounds, bounds),
             center + Vector3(bounds, bounds, -bounds),
-            center + Vector3(-bounds, bounds, -bounds), blockData->blockID).reverse();
+            center + Vector3(-bounds, bounds, -bounds), blockData()->blockID).reverse();
     case BOTTOM:
         return Face(center + Vector3(-bounds, -bounds, bounds),
             center + Vector3(bounds, -bounds, bounds),
             center + Vector3(bounds, -bounds, -bounds),
-            center + Vector3(-bounds, -bounds, -bounds), blockData->blockID);
+            center + Vector3(-bounds, -bounds, -bounds), blockData()->blockID);
     case NORTH:
         return Face(center + Vector3(bounds, -bounds, bounds),
             center + Vector3(bounds, bounds, bounds),
             center + Vector3(bounds, bounds, -bounds),
-            center + Vector3(bounds, -bounds, -bounds), blockData->blockID);
+            center + Vector3(bounds, -bounds, -bounds), blockData()->blockID);
     case SOUTH:
         return Face(center + Vector3(-bounds, -bounds, bounds),
             center + Vector3(-bounds, bounds, bounds),
             center + Vector3(-bounds, bounds, -bounds),
-            center + Vector3(-bounds, -bounds, -bounds), blockData->blockID).reverse();
+            center + Vector3(-bounds, -bounds, -bounds), blockData()->blockID).reverse();
     case EAST:
         return Face(center + Vector3(-bounds, bounds, bounds),
             center + Vector3(bounds, bounds, bounds),
             center + Vector3(bounds, -bounds, bounds),
-            center + Vector3(-bounds, -bounds, bounds), blockData->blockID);
+            center + Vector3(-bounds, -bounds, bounds), blockData()->blockID);
     case WEST:
         return Face(center + Vector3(-bounds, bounds, -bounds),
             center + Vector3(bounds, bounds, -bounds),
             center + Vector3(bounds, -bounds, -bounds),
-            center + Vector3(-bounds, -bounds, -bounds), blockData->blockID).reverse();
+            center + Vector3(-bounds, -bounds, -bounds), blockData()->blockID).reverse();
     }
 	return Face({0, 0, 0}, {0, 0, 0}, {0, 0, 0});
 }
 
 
 //Function which gets the visible faces from a voxel instance
+// (faces never need to be de-duplicated, the voxels visited by iterate() don't overlap so no two of them share a face)
 void VoxelInstance::getFaces(std::vector<Face>& out){
-    if(blockData->checkFlag(BlockData::INVISIBLE))
+    if(blockData()->checkFlag(BlockData::INVISIBLE))
         return;
-    // Lambda which determines if the array contains a face already
-    auto notHas = [&out](Face& what){
-        for(const Face& f: out)
-            if(f == what)
-                return false;
-        return true;
-    };
-    //auto notHasR = [notHas](Face&& what){ return notHas(what); };
-    if(checkFlag(TOP_VISIBLE)){
-        Face f = getFace(TOP);
-        //if(notHas(f) && notHasR(f.reverse())) out.push_back(f);
-        if(notHas(f)) out.push_back(f);
-    }
-    if(checkFlag(BOTTOM_VISIBLE)){
-        Face f = getFace(BOTTOM);
-        //if(notHas(f) && notHasR(f.reverse())) out.push_back(f);
-        if(notHas(f)) out.push_back(f);
-    }
-    if(checkFlag(NORTH_VISIBLE)){
-        Face f = getFace(NORTH);
-        //if(notHas(f) && notHasR(f.reverse())) out.push_back(f);
-        if(notHas(f)) out.push_back(f);
-    }
-    if(checkFlag(SOUTH_VISIBLE)){
-        Face f = getFace(SOUTH);
-        //if(notHas(f) && notHasR(f.reverse())) out.push_back(f);
-        if(notHas(f)) out.push_back(f);
-    }
-    if(checkFlag(EAST_VISIBLE)){
-        Face f = getFace(EAST);
-        //if(notHas(f) && notHasR(f.reverse())) out.push_back(f);
-        if(notHas(f)) out.push_back(f);
-    }
-    if(checkFlag(WEST_VISIBLE)){
-        Face f = getFace(WEST);
-        //if(notHas(f) && notHasR(f.reverse())) out.push_back(f);
-        if(notHas(f)) out.push_back(f);
-    }
+    if(checkFlag(TOP_VISIBLE))
+        out.push_back(getFace(TOP));
+    if(checkFlag(BOTTOM_VISIBLE))
+        out.push_back(getFace(BOTTOM));
+    if(checkFlag(NORTH_VISIBLE))
+        out.push_back(getFace(NORTH));
+    if(checkFlag(SOUTH_VISIBLE))
+        out.push_back(getFace(SOUTH));
+    if(checkFlag(EAST_VISIBLE))
+        out.push_back(getFace(EAST));
+    if(checkFlag(WEST_VISIBLE))
+        out.push_back(getFace(WEST));
 }
 
 // Function which recursively calculates the center of all of the sub voxels
@@ -291,19 +309,91 @@ void VoxelInstance::calculateCenters(){
     }
 }
 
-// Function which recursively calculates the visibility of all the subVoxels
+// Table describing each Direction's face: the Morton bit of its axis, if it points along the positive axis,
+// the visibility flag it sets, and the unit offset to the neighboring voxel
+static const struct {
+    int bit;
+    bool positive;
+    VoxelInstance::Flags flag;
+    Vector3 offset;
+} faceTable[6] = {
+    {1, true, VoxelInstance::NORTH_VISIBLE, Vector3(1, 0, 0)},
+    {1, false, VoxelInstance::SOUTH_VISIBLE, Vector3(-1, 0, 0)},
+    {4, true, VoxelInstance::EAST_VISIBLE, Vector3(0, 0, 1)},
+    {4, false, VoxelInstance::WEST_VISIBLE, Vector3(0, 0, -1)},
+    {2, true, VoxelInstance::TOP_VISIBLE, Vector3(0, 1, 0)},
+    {2, false, VoxelInstance::BOTTOM_VISIBLE, Vector3(0, -1, 0)}
+};
+
+// Function which recursively calculates the visibility of all the subVoxels,
+// only the 6 neighbors of this voxel are looked up in the map, everything below is found by walking the tree
 void VoxelInstance::calculateVisibility(){
+    VoxelInstance* neighbors[6];
+    findNeighbors(neighbors);
+    calculateVisibility(neighbors);
+}
+
+// Function which recalculates the visibility of this voxel's faces (the subVoxels are left alone)
+void VoxelInstance::updateVisibility(){
+    VoxelInstance* neighbors[6];
+    findNeighbors(neighbors);
+    setVisibility(neighbors);
+}
+
+// Function which looks up the voxels touching each of this voxel's faces in the map (indexed by Direction)
+void VoxelInstance::findNeighbors(VoxelInstance* neighbors[6]){
+    // Distance to the center of the next voxel
+    float distance = pow(2, level);
+    for(int d = 0; d < 6; d++)
+        neighbors[d] = map->find(level, center + faceTable[d].offset * distance);
+}
+
+// Function which sets the visibility flags of this voxel given the voxels touching each of its faces
+void VoxelInstance::setVisibility(VoxelInstance* const neighbors[6]){
+    for(int d = 0; d < 6; d++)
+        // Nothing or something transparent next to a face makes it visible
+        if(!neighbors[d] || neighbors[d]->blockData()->checkFlag(BlockData::TRANSPARENT))
+            flags |= faceTable[d].flag;
+        else
+            flags &= ~faceTable[d].flag;
+}
+
+// Function which recursively calculates the visibility of all the subVoxels given the voxels touching each of this voxel's faces,
+// <neighbors> are indexed by Direction and are either on this voxel's level or are leaves above it (nullptr if there is nothing there)
+void VoxelInstance::calculateVisibility(VoxelInstance* const neighbors[6]){
+    setVisibility(neighbors);
+    if(!subVoxels) return;
+
+    for(int m = 0; m < 8; m++){
+        VoxelInstance* childNeighbors[6];
+        for(int d = 0; d < 6; d++){
+            // The child on the other side of the face (if it were in the same parent)
+            int across = m ^ faceTable[d].bit;
+            // If the face points inward the neighbor is a sibling
+            if(bool(m & faceTable[d].bit) != faceTable[d].positive)
+                childNeighbors[d] = &subVoxels[mortonToSubVoxel[across]];
+            // Otherwise it is the matching child of our neighbor...
+            else if(neighbors[d] && neighbors[d]->subVoxels)
+                childNeighbors[d] = &neighbors[d]->subVoxels[mortonToSubVoxel[across]];
+            // Or our neighbor itself if it is a leaf
+            else
+                childNeighbors[d] = neighbors[d];
+        }
+        subVoxels[mortonToSubVoxel[m]].calculateVisibility(childNeighbors);
+    }
+}
+
+// Function which recursively calculates the visibility of all the subVoxels by looking up every neighbor from the root of its chunk
+// (kept as a reference for the neighbor traversal above)
+void VoxelInstance::calculateVisibilityByLookup(){
     #define setFlag(flag, vector)\
     { VoxelInstance* v = map->find(level, center + vector);\
     if(!v)\
         flags |= flag;\
         /*flags = flags & ~flag;*/\
-    else if(v->blockData){\
-		if(v->blockData->checkFlag(BlockData::TRANSPARENT))\
-        	flags = flags | flag;\
-		else\
-	        flags = flags & ~flag;\
-    } else\
+    else if(v->blockData()->checkFlag(BlockData::TRANSPARENT))\
+        flags = flags | flag;\
+    else\
         flags = flags & ~flag;\
     }
     // Distance to the center of the next voxel
@@ -320,10 +410,11 @@ void VoxelInstance::calculateVisibility(){
     setFlag(VoxelInstance::EAST_VISIBLE, Vector3(0, 0, distance));
     // West
     setFlag(VoxelInstance::WEST_VISIBLE, Vector3(0, 0, -distance));
+    #undef setFlag
 
     if(subVoxels)
         for(int i = 0; i < 8; i++)
-            subVoxels[i].calculateVisibility();
+            subVoxels[i].calculateVisibilityByLookup();
 }
 
 // Function which loops over every block
@@ -342,74 +433,6 @@ void VoxelInstance::iterate(int lvl, IterationFunction func_ptr, int& index, boo
         func_ptr(this, index++);
 }
 
-// Function which gets all of the faces in one layer coming from a specified direction (builds the face array internally)
-std::vector<Face> VoxelInstance::getLayerFaces(const Direction direction, const int whichLevel, const int levelOfDetail){
-	// Get all of the faces
-    std::vector<Face> faces;
-    iterate(levelOfDetail, [&faces](VoxelInstance* v, int) {
-        v->getFaces(faces);
-    });
-
-	return getLayerFaces(direction, whichLevel, levelOfDetail);
-}
-
-// Function which gets all of the faces in one layer coming from a specified direction
-std::vector<Face> VoxelInstance::getLayerFaces(const Direction direction, const int whichLevel, const std::vector<Face>& faces){
-    // Variable storing the eventual output
-    std::vector<Face> out;
-
-    // Variable storing the coordinate in world space to compare verticies too
-    float match;
-    // Variable storing the desired normal of all of the faces
-    Vector3 normal;
-    // Calculate the values for <normal> and <match>
-    switch (direction){
-    case TOP:
-        match = center.y + CHUNK_DIMENSIONS / 2 - whichLevel;
-        normal = Vector3(0, 1, 0);
-        break;
-    case BOTTOM:
-        match = center.y - CHUNK_DIMENSIONS / 2 + whichLevel;
-        normal = Vector3(0, -1, 0);
-        break;
-    case NORTH:
-        match = center.x + CHUNK_DIMENSIONS / 2 - whichLevel;
-        normal = Vector3(1, 0, 0);
-        break;
-    case SOUTH:
-        match = center.x - CHUNK_DIMENSIONS / 2 + whichLevel;
-        normal = Vector3(-1, 0, 0);
-        break;
-    case EAST:
-        match = center.z + CHUNK_DIMENSIONS / 2 - whichLevel;
-        normal = Vector3(0, 0, 1);
-        break;
-    case WEST:
-        match = center.z - CHUNK_DIMENSIONS / 2 + whichLevel;
-        normal = Vector3(0, 0, -1);
-        break;
-    }
-
-    #define check(axis)\
-        /* For each face */\
-        for(const Face& f: faces)\
-            /* Check if three of it's points are in the plane (assuming square faces don't oddly tilt one verticie) */\
-            if(f.a.point.axis == match && f.b.point.axis == match && f.c.point.axis == match)\
-                /* Check if the face is oriented in the correct direction */\
-                if(f.normal == normal)\
-                    out.push_back(f)
-
-    // Add all of the faces in the desired plane with the correct orientation to the output...
-    if(direction == NORTH || direction == SOUTH) {
-        check(x);
-    } else if(direction == TOP || direction == BOTTOM) {
-        check(y);
-    } else if(direction == EAST || direction == WEST)
-        check(z);
-    // Return the layer
-    return out;
-}
-
 // Debug functions
 int VoxelInstance::count(){
     int count = 0;
@@ -435,8 +458,8 @@ String to_string(bool what){
 }
 
 String VoxelInstance::dump(){
-    String out = copy('\t', SUBCHUNK_LEVELS - level) + to_string(level) + " - " + to_string(blockData->blockID) +
-        " - " + to_string(flags) + " - " + to_string(blockData->checkFlag(BlockData::TRANSPARENT))+ " - {" + center + "}\n";
+    String out = copy('\t', SUBCHUNK_LEVELS - level) + to_string(level) + " - " + to_string(blockData()->blockID) +
+        " - " + to_string(flags) + " - " + to_string(blockData()->checkFlag(BlockData::TRANSPARENT))+ " - {" + center + "}\n";
     if(subVoxels)
         for(size_t i = 0; i < 8; i++)
             out += subVoxels[i].dump();
@@ -446,34 +469,322 @@ String VoxelInstance::dump(){
 /*------------------------------------------------------------------------------
         Chunk
 ------------------------------------------------------------------------------*/
+// Function which sets up the chunk's storage (filled with air)
+void Chunk::initalize(ChunkMap* map, Storage storage /*= OCTREE*/){
+	this->map = map;
+	this->storage = storage;
+	BlockState air = BlockDatabase::getSingleton()->getDefaultState(Blocks::AIR);
+	level = SUBCHUNK_LEVELS;
+	blockState = air;
+	if(storage == OCTREE){
+		// An empty chunk is a single pruned leaf of air
+		if(subVoxels) freeSubVoxels();
+		recalculate();
+		return;
+	}
+
+	// The octree will be built once something asks for it
+	if(storage == PALETTED)
+		blocks.reset(CHUNK_ARRAY_SIZE, air);
+	else
+		linear.reset(SUBCHUNK_LEVELS, air);
+	octreeDirty = true;
+}
+
+// Function which fills the chunk from an array of blockIDs (indexed by blockIndex())
+void Chunk::loadFromArray(const std::vector<int>& array){
+	if(!map) throw "Chunk Map not found";
+	BlockDatabase* db = BlockDatabase::getSingleton();
+	fillBlocks([&array, db](int x, int y, int z){
+		return db->getDefaultState(array[blockIndex(x, y, z)]);
+	});
+}
+
+// Function which converts the chunk to a different storage backend
+void Chunk::setStorage(Storage mode){
+	if(mode == storage) return;
+
+	// Make sure the octree holds every block, then copy them into the new backend
+	ensureOctree();
+	if(storage == PALETTED)
+		blocks.reset(0);
+	else if(storage == LINEAR)
+		linear.reset(0);
+
+	if(mode == PALETTED)
+		copyOctreeToDense();
+	else if(mode == LINEAR)
+		toLinear(linear);
+	storage = mode;
+	// The octree was just copied, so it is still up to date
+	octreeDirty = false;
+}
+
+// Function which copies the blocks in the octree into the dense storage
+void Chunk::copyOctreeToDense(){
+	blocks.reset(CHUNK_ARRAY_SIZE, blockState);
+	Vector3 corner = center - Vector3(CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS / 2);
+	iterate(BLOCK_LEVEL, [this, corner](VoxelInstance* v, int){
+		// Pruned leaves cover more than one block
+		int size = 1 << v->level;
+		Vector3 min = v->center - corner - Vector3(size / 2.0, size / 2.0, size / 2.0);
+		for(int x = min.x; x < min.x + size; x++)
+			for(int z = min.z; z < min.z + size; z++)
+				for(int y = min.y; y < min.y + size; y++)
+					blocks.set(blockIndex(x, y, z), v->blockState);
+	});
+}
+
+// Function which gets the state of the block at the provided chunk-local block coordinates
+BlockState Chunk::getBlockState(int x, int y, int z){
+	if(storage == PALETTED)
+		return blocks.get(blockIndex(x, y, z));
+	if(storage == LINEAR)
+		return linear.get(x, y, z);
+	return find(BLOCK_LEVEL, ivec3(x, y, z))->blockState;
+}
+
+// Function which sets the state of the block at the provided chunk-local block coordinates
+void Chunk::setBlockState(int x, int y, int z, BlockState state){
+	edited = true;
+	if(storage == PALETTED){
+		blocks.set(blockIndex(x, y, z), state);
+		octreeDirty = true;
+		// The octree will be rebuilt, but the neighboring chunks still need to be updated
+		if(map) map->markDirty(getCorner() + ivec3(x, y, z));
+		return;
+	} else if(storage == LINEAR){
+		linear.set(x, y, z, state);
+		octreeDirty = true;
+		if(map) map->markDirty(getCorner() + ivec3(x, y, z));
+		return;
+	}
+
+	// Walk down to the block, splitting any leaves along the way
+	VoxelInstance* path[SUBCHUNK_LEVELS + 1];
+	int depth = 0;
+	VoxelInstance* v = this;
+	while(v->level > BLOCK_LEVEL){
+		if(!v->subVoxels){
+			if(v->blockState == state) return; // The block already has the state
+			v->split();
+			// The new subVoxels need their own visibility
+			if(map) v->recalculate();
+		}
+		path[depth++] = v;
+		v = v->find(v->level - 1, ivec3(x, y, z));
+	}
+	if(v->blockState == state) return;
+	v->blockState = state;
+
+	// Walk back up re-merging the ancestors
+	while(depth)
+		path[--depth]->merge();
+
+	// Only the voxels around the block need their visibility updated
+	if(map) map->markDirty(getCorner() + ivec3(x, y, z));
+}
+
+// Function which makes sure the octree is up to date with the chunk's storage (only does work in PALETTED and LINEAR mode)
+void Chunk::ensureOctree(){
+	if(storage == OCTREE || !octreeDirty) return;
+	// Mark the octree clean first, since recalculating may look up blocks in this chunk
+	octreeDirty = false;
+
+	if(storage == LINEAR)
+		fromLinear(linear);
+	else {
+		// Unpack the palette and build the octree bottom up
+		std::vector<BlockState> dense(CHUNK_ARRAY_SIZE);
+		for(size_t i = 0; i < dense.size(); i++)
+			dense[i] = blocks.get(i);
+		level = SUBCHUNK_LEVELS;
+		build(dense.data());
+	}
+	recalculate();
+}
+
+// Function which frees the octree, it will be rebuilt the next time it is needed (only does work in PALETTED and LINEAR mode)
+void Chunk::dropOctree(){
+	if(storage == OCTREE) return;
+	nodeArena.clear();
+	subVoxels = nullptr;
+	octreeDirty = true;
+}
+
+// Function which creates a pointerless copy of the chunk's blocks (safe to hand to other threads)
+LinearOctree Chunk::snapshot(){
+	if(storage == LINEAR)
+		return linear;
+
+	ensureOctree();
+	LinearOctree out;
+	toLinear(out);
+	return out;
+}
+
+// Function which gets the number of bytes used to store the chunk's blocks
+size_t Chunk::memoryUsage() const {
+	size_t out = sizeof(VoxelInstance) + nodeArena.capacity();
+	if(storage == PALETTED)
+		out += blocks.memoryUsage();
+	else if(storage == LINEAR)
+		out += linear.memoryUsage();
+	return out;
+}
+
 // Function which rebuild's the chunk's mesh at the desired <levelOfDetail>
 void Chunk::rebuildMesh(int levelOfDetail){
-	Timer t;
-	Surface surf;
-	std::vector<Face> facesArr;
-    iterate(levelOfDetail, [&facesArr](VoxelInstance* me, int) {
-        me->getFaces(facesArr);
-    });
-
-    if(facesArr.size())
-        for (Face& f: facesArr)
-            surf.append(f.getSurface());
-        //surf = Surface::fromContiguousCoplanarFaces(facesArr);*/
+	ensureOctree();
+	meshLevelOfDetail = levelOfDetail;
+	// Show a quick mesh built from the visibility flags until the optimized mesh is ready (if there is nothing to show yet)
+	if(get_mesh().is_null()){
+		Surface surf;
+		std::vector<Face> facesArr;
+		iterate(levelOfDetail, [&facesArr](VoxelInstance* me, int) {
+			me->getFaces(facesArr);
+		});
+
+		surf.reserve(facesArr.size());
+		for (Face& f: facesArr)
+			surf += f;
+		setSurface(surf);
+	}
+
+	// Chunks which aren't part of a map don't have any workers to mesh them
+	if(!map) return buildOptimizedMesh(levelOfDetail);
+	// Queue a snapshot of the chunk's blocks to be meshed by the workers (closer chunks are meshed first)
+	VoxelGrid grid;
+	grid.capture(*this, levelOfDetail);
+	meshGeneration = map->meshWorkers.submit(std::move(grid), (center - map->viewer).length(), weldVertices, wireframe != nullptr, chooseMesher(levelOfDetail));
+}
 
-    set_mesh(surf.getMesh());
-	// TODO: be careful since block updates may cause issues with this system
-	// Create a new thread to create an optimzed mesh
-	std::thread(&Chunk::buildOptimizedMesh, this, levelOfDetail).detach();
+// Function which picks the mesher the chunk is meshed with at <levelOfDetail>
+const Mesher* Chunk::chooseMesher(int levelOfDetail) const {
+	const Mesher* m = mesher ? mesher : Mesher::get(Mesher::BLOCKY);
+	return levelOfDetail >= THOROUGH_MESH_LEVEL && !edited ? m->thorough() : m;
 }
 
-// Function which creates an greedily optimized version of the mesh
+// Function which meshes the chunk on the calling thread
 void Chunk::buildOptimizedMesh(int levelOfDetail){
-	Timer t;
-	// Get all of the faces
-    std::vector<Face> faces;
-    iterate(levelOfDetail, [&faces](VoxelInstance* v, int) {
-        v->getFaces(faces);
-    });
+	const Mesher* m = chooseMesher(levelOfDetail);
+	// Mesh a snapshot of the chunk's blocks (keeping the layers separate so they can be remeshed individually, if the mesher can)
+	VoxelGrid grid;
+	grid.capture(*this, levelOfDetail);
+	if(!meshLayers) meshLayers.reset(new LayerSurfaces);
+	meshLevelOfDetail = levelOfDetail;
+	// Any queued job was built from an older snapshot
+	meshGeneration = 0;
+	if(m->meshLayers(grid, *meshLayers))
+		uploadLayers();
+	else {
+		meshLayers.reset();
+		Surface surf = m->mesh(grid);
+		setSurface(surf);
+	}
+}
+
+// Function which sets a mesh built by the map's workers as the chunk's mesh, returns false (and takes nothing) if the chunk
+// has been queued to be meshed again since the job with the given <generation> was queued
+// (<wireframe> is the outline of the mesh if the job built one)
+bool Chunk::commitMesh(uint64_t generation, int levelOfDetail, std::unique_ptr<LayerSurfaces>& layers, Surface& chunkSpace, Surface* wireframe /*= nullptr*/){
+	if(generation != meshGeneration) return false;
+	meshLayers = std::move(layers);
+	meshLevelOfDetail = levelOfDetail;
+	meshGeneration = 0;
+	showSurface(chunkSpace, wireframe);
+	return true;
+}
+
+// Function which rebuilds a single layer of the optimized mesh (falls back to rebuilding the whole mesh if the mesh isn't split into layers)
+void Chunk::remeshLayer(Direction d, int layer){
+	// Nothing to update if the chunk hasn't been meshed
+	if(get_mesh().is_null()) return;
+	// If a job is queued its result would replace the layer with one built from an older snapshot, so queue a new job instead
+	if(!meshLayers || meshGeneration) return rebuildMesh(meshLevelOfDetail);
+
+	VoxelGrid grid;
+	grid.captureLayer(*this, d, layer, meshLevelOfDetail);
+	const Mesher* m = chooseMesher(meshLevelOfDetail);
+	if(!m->meshLayer(grid, d, layer, (*meshLayers)[d][layer])) return rebuildMesh(meshLevelOfDetail);
+	uploadLayers();
+}
+
+// Function which joins the layers of the optimized mesh and sets them as the chunk's mesh
+void Chunk::uploadLayers(){
+	Surface surf = joinLayers(*meshLayers);
+	setSurface(surf);
+}
+
+// Function which joins a surface split up by layer back into a single surface
+Surface Chunk::joinLayers(const LayerSurfaces& layers){
+	Surface out;
+	size_t quads = 0;
+	for(int d = NORTH; d <= BOTTOM; d++)
+		for(int layer = 0; layer < CHUNK_DIMENSIONS; layer++)
+			quads += layers[d][layer].verts.size() / 4;
+	out.reserve(quads);
+	for(int d = NORTH; d <= BOTTOM; d++)
+		for(int layer = 0; layer < CHUNK_DIMENSIONS; layer++)
+			out += layers[d][layer];
+	return out;
+}
+
+// Function which welds a surface (if enabled), moves it into chunk space, and sets it as the chunk's mesh
+void Chunk::setSurface(Surface& surf){
+	if(weldVertices) surf.weld();
+	// Relative to the center of the chunk every blocky vertex is a small integer, which a half float stores exactly
+	surf.translate(-center);
+	showSurface(surf);
+}
+
+// Function which sets a surface which is already in chunk space as the chunk's mesh (and updates the wireframe if one is shown,
+// using <wireframe> if the outline of the surface has already been built)
+void Chunk::showSurface(Surface& chunkSpace, Surface* wireframe /*= nullptr*/){
+	// Smooth vertices fall between block coordinates, as half floats they would be rounded differently on each side of a seam
+	bool compact = compactVertices && chooseMesher(meshLevelOfDetail)->integerPositions();
+	int64_t format = compact ? Surface::COMPACT_FORMAT : Mesh::ARRAY_COMPRESS_DEFAULT;
+	set_translation(center);
+	// Each material the blocks are drawn with gets its own surface
+	set_mesh(chunkSpace.getMesh(nullptr, format, Mesh::PRIMITIVE_TRIANGLES, map ? &map->materials : nullptr));
+	// Keep the wireframe (if one is shown) in sync with the mesh
+	if(this->wireframe){
+		Surface lines = wireframe ? std::move(*wireframe) : chunkSpace.getWireframe();
+		// The lines are lifted a fraction of a unit off the surface, which half floats can't store
+		this->wireframe->set_mesh(lines.getMesh(nullptr, Mesh::ARRAY_COMPRESS_DEFAULT, Mesh::PRIMITIVE_LINES));
+	}
+}
+
+// Function which sorts the visible faces of the chunk into the layer they lie in, in a single pass
+void Chunk::getLayerFaces(LayerFaces& layers, int levelOfDetail /*= 0*/){
+	ensureOctree();
+	ivec3 corner = getCorner();
+	iterate(levelOfDetail, [&layers, corner](VoxelInstance* v, int) {
+		if(v->blockData()->checkFlag(BlockData::INVISIBLE))
+			return;
+		// Integer bounds of the voxel in chunk-local block coordinates
+		int size = 1 << v->level;
+		ivec3 min = ivec3::floor(v->center - Vector3(size / 2.0, size / 2.0, size / 2.0)) - corner;
+		ivec3 max = min + ivec3(size, size, size);
+
+		// Layers are counted from the side the faces point towards
+		if(v->checkFlag(TOP_VISIBLE)) layers[TOP][CHUNK_DIMENSIONS - max.y].push_back(v->getFace(TOP));
+		if(v->checkFlag(BOTTOM_VISIBLE)) layers[BOTTOM][min.y].push_back(v->getFace(BOTTOM));
+		if(v->checkFlag(NORTH_VISIBLE)) layers[NORTH][CHUNK_DIMENSIONS - max.x].push_back(v->getFace(NORTH));
+		if(v->checkFlag(SOUTH_VISIBLE)) layers[SOUTH][min.x].push_back(v->getFace(SOUTH));
+		if(v->checkFlag(EAST_VISIBLE)) layers[EAST][CHUNK_DIMENSIONS - max.z].push_back(v->getFace(EAST));
+		if(v->checkFlag(WEST_VISIBLE)) layers[WEST][min.z].push_back(v->getFace(WEST));
+	});
+}
+
+// Function which greedily meshes the chunk by sorting its faces into layers (the slower reference for BinaryMesher)
+Surface Chunk::buildCoplanarSurface(int levelOfDetail){
+	// Sort the faces into layers
+	LayerFaces layers;
+	getLayerFaces(layers, levelOfDetail);
+
+	// Every face at this level of detail lines up with the voxels of this level, so the layers can be meshed on a coarser grid
+	int scale = 1 << levelOfDetail;
 
 	// Build the faces for each direction
 	Surface surf;
@@ -495,22 +806,29 @@ void Chunk::buildOptimizedMesh(int levelOfDetail){
 			else if(d == Direction::WEST)
 				layerCenter += Vector3(0, 0, level - CHUNK_DIMENSIONS / 2);
 			// Use the greedy meshing algorithm to simplify the layer's mesh
-			surf += Surface::GreedyMeshCoplanar(getLayerFaces((Direction) d, level, faces), (Direction) d, layerCenter);
+			if(layers[d][level].size())
+				surf += Surface::GreedyMeshCoplanar(std::move(layers[d][level]), (Direction) d, layerCenter, CHUNK_DIMENSIONS / scale, scale);
 		}
-	set_mesh(surf.getMesh());
-	gout << "optimized to "  << get_mesh()->get_faces().size() / 3 << " faces" << endl;
-	std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-	buildWireframe();
+	return surf;
 }
 
-// Function which computes a wireframe version of the mesh
+// Function which shows the edges of the chunk's mesh as lines, from then on the wireframe is rebuilt along with the mesh
 void Chunk::buildWireframe(){
+	// A single line mesh child (rather than a node per triangle) which is reused for every mesh the chunk is given
+	if(!wireframe){
+		wireframe = MeshInstance::_new();
+		wireframe->set_name("Wireframe");
+		add_child(wireframe);
+	}
+
+	// Outline the mesh which is currently shown (later meshes are outlined as they are built)
 	Surface surf;
-	PoolVector3Array verts = get_mesh()->get_faces();
-	gout << get_mesh()->get_faces().size() / 3 << endl;
-	for(int i = 0; i < verts.size(); i += 3)
-		surf += Face(verts[i], verts[i + 1], verts[i + 2]).getSurface();
-
-	if(has_node("Wireframe")) get_node("Wireframe")->queue_free();
-    add_child(surf.getWireframe());
+	if(get_mesh().is_valid()){
+		PoolVector3Array verts = get_mesh()->get_faces();
+		surf.reserve(verts.size() / 3);
+		for(int i = 0; i + 2 < verts.size(); i += 3)
+			surf += Face(verts[i], verts[i + 1], verts[i + 2]);
+	}
+	Surface lines = surf.getWireframe();
+	wireframe->set_mesh(lines.getMesh(nullptr, Mesh::ARRAY_COMPRESS_DEFAULT, Mesh::PRIMITIVE_LINES));
 }
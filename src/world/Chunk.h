@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <functional>
+#include <memory>
 
 #include <MeshInstance.hpp>
 
@@ -11,6 +12,10 @@
 #include "../SurfFaceEdge.h"
 
 #include "../godot/Gstream.hpp"
+#include "VoxelArena.h"
+#include "PalettedStorage.h"
+#include "LinearOctree.h"
+#include "ivec3.h"
 
 using namespace godot;
 
@@ -29,6 +34,7 @@ const int BLOCK_LEVEL = 0;
 class VoxelInstance;
 //class Face;
 class ChunkMap;
+class Mesher;
 
 typedef std::function<void(VoxelInstance*, int)> IterationFunction;
 
@@ -46,8 +52,9 @@ public:
 
 
 	};
-	BlockData* blockData;
 	flag_t flags = Flags::null;
+	// Index of this voxel's block in the BlockDatabase's palette of shared block states
+	BlockState blockState = 0;
 
 	//unsigned int blockID = 0;
 	// variable storing which level of subchunk this instance is
@@ -57,36 +64,51 @@ public:
 	VoxelInstance* subVoxels = nullptr;
 	//VoxelInstance* parent = nullptr;
 	ChunkMap* map = nullptr;
+	// Arena which owns the storage for subVoxels (nullptr if they are individually heap allocated)
+	VoxelArena* arena = nullptr;
 
-	VoxelInstance(ChunkMap* map = nullptr, BlockData* data = new BlockData()){
+	VoxelInstance(ChunkMap* map = nullptr, BlockState state = 0){
 		this->map = map;
-		this->blockData = data;
+		this->blockState = state;
 	}
 
-	// Copy constructor
-	VoxelInstance(VoxelInstance& origin);
-	// Move constructor
-	VoxelInstance(VoxelInstance&& origin);
-
 	~VoxelInstance(){
-		if(subVoxels) delete [] subVoxels;
-		if(blockData) delete blockData;
+		// Arena owned children are freed in bulk by the arena
+		if(subVoxels && !arena) delete [] subVoxels;
 	}
 
+	// Function which gets the shared data describing this voxel's block
+	const BlockData* blockData() const { return BlockDatabase::getSingleton()->getState(blockState); }
+
 	// Function which recursiveley converts an array of blockIDs into an octree
 	void init(int level = SUBCHUNK_LEVELS, bool originalCall = true);
 	// Function which merges sublevels containing all of the same blockID into the same level
 	bool prune();
+	// Function which builds this branch bottom up from a dense array of block states (indexed by Chunk::blockIndex),
+	// <x, y, z> are the chunk-local coordinates of this voxel's minimum corner
+	void build(const BlockState* blocks, int x = 0, int y = 0, int z = 0);
 	// Function which takes a pruned tree and rebuilds the lower levels of the tree down to the block level
 	// The purpose of this function is to rebuild a branch of the tree when we need to modify a blockID in that branch
 	void unprune(bool originalCall = true);
+	// Function which splits a leaf into 8 subVoxels with the same state (only one level is created)
+	void split();
+	// Function which merges the subVoxels if they are uniform leaves (otherwise updates this voxel's state to their mode),
+	// only this level is looked at so the subVoxels should already be merged
+	bool merge();
 	// Function which given an arbitrary point in 3D space within the voxel
 	// finds the subvoxel of the requested <lvl> which contains the point
 	VoxelInstance* find(int lvl, Vector3& position);
 	VoxelInstance* find(int lvl, Vector3&& position) { return find(lvl, position); }
+	// Function which finds the subvoxel of the requested <lvl> containing the block at the provided chunk-local block coordinates,
+	// the child at each level is picked directly from the coordinate's bits
+	VoxelInstance* find(int lvl, const ivec3& position);
 	// Function which determines if an arbitrary point in space is within this voxel
 	bool within(Vector3& position);
 	bool within(Vector3&& position){ return within(position); }
+	// Function which copies this branch into a linear octree (<index> is the node in <tree> representing this instance)
+	void toLinear(LinearOctree& tree, uint32_t index = 0) const;
+	// Function which rebuilds this branch from a linear octree (centers must be recalculated afterwords)
+	void fromLinear(const LinearOctree& tree, uint32_t index = 0);
 	// Function which gets a single face
 	Face getFace(Direction d);
 	//Function which gets the visible faces from a voxel instance
@@ -101,10 +123,14 @@ public:
 		calculateCenters();
 		calculateVisibility();
 	}
-
-	// Function which gets all of the faces in one layer coming from a specified direction
-	std::vector<Face> getLayerFaces(const Direction direction, const int whichLevel, const int levelOfDetail = 0);
-	std::vector<Face> getLayerFaces(const Direction direction, const int whichLevel, const std::vector<Face>& faces);
+	// Function which recalculates the visibility of this voxel's faces (the subVoxels are left alone)
+	void updateVisibility();
+	// Function which preforms all of the nessicary chunk calculations, looking up the neighbors of every voxel from the root of its chunk
+	// (slower reference for recalculate())
+	void recalculateByLookup(){
+		calculateCenters();
+		calculateVisibilityByLookup();
+	}
 
 	//Function which runs the provided function for every instance recursively
 	int iterate(int level, IterationFunction func_ptr, bool threaded = false){
@@ -122,8 +148,8 @@ public:
 	void save(Archive& archive) const {
 		// Save instance
 		archive(
-			cereal::make_nvp("blockID", blockData->blockID),
-			cereal::make_nvp("features", *blockData),
+			cereal::make_nvp("blockID", blockData()->blockID),
+			cereal::make_nvp("features", *blockData()),
 			CEREAL_NVP(flags),
 			CEREAL_NVP(level),
 			CEREAL_NVP(center)
@@ -142,23 +168,24 @@ public:
 		// Load block data
 		Identifier blockID;
 		archive(cereal::make_nvp("blockID", blockID));
-		if(blockData) delete blockData;
-		blockData = BlockDatabase::getSingleton()->getBlock(blockID);
+		BlockData* data = BlockDatabase::getSingleton()->getBlock(blockID);
 
 		// Load block instance
 		archive(
-			cereal::make_nvp("features", *blockData),
+			cereal::make_nvp("features", *data),
 			CEREAL_NVP(flags),
 			CEREAL_NVP(level),
 			CEREAL_NVP(center)
 		);
+		// Share the loaded state with every other voxel which has the same features
+		blockState = BlockDatabase::getSingleton()->internState(data);
 
 		// Load children
 		bool hasChildren;
 		archive(cereal::make_nvp("hasChildren", hasChildren));
-		if(subVoxels) delete [] subVoxels;
+		if(subVoxels) freeSubVoxels();
 		if(hasChildren){
-			subVoxels = new VoxelInstance [8];
+			allocateSubVoxels();
 			for(int i = 0; i < 8; i++)
 				archive( cereal::make_nvp((std::string("child-") + std::to_string(i)).c_str(), subVoxels[i]) );
 		} else
@@ -170,12 +197,25 @@ public:
 	String dump();
 
 protected:
+	// Function which creates the next sublevel (from the arena if this instance has one)
+	void allocateSubVoxels();
+	// Function which removes the next sublevel (returning it to the arena if this instance has one)
+	void freeSubVoxels();
 	// Function which loops over every block
 	void iterate(int lvl, IterationFunction func_ptr, int& index, bool threaded);
 	// Function which recursively calculates the center of all of the sub voxels
 	void calculateCenters();
-	// Function which recursively calculates the visibility of all the subVoxels
+	// Function which recursively calculates the visibility of all the subVoxels,
+	// only the 6 neighbors of this voxel are looked up in the map, everything below is found by walking the tree
 	void calculateVisibility();
+	// Function which recursively calculates the visibility of all the subVoxels given the voxels touching each of this voxel's faces
+	void calculateVisibility(VoxelInstance* const neighbors[6]);
+	// Function which looks up the voxels touching each of this voxel's faces in the map (indexed by Direction)
+	void findNeighbors(VoxelInstance* neighbors[6]);
+	// Function which sets the visibility flags of this voxel given the voxels touching each of its faces
+	void setVisibility(VoxelInstance* const neighbors[6]);
+	// Function which recursively calculates the visibility of all the subVoxels by looking up every neighbor from the root of its chunk
+	void calculateVisibilityByLookup();
 
 };
 
@@ -189,8 +229,23 @@ public:
 		register_method("_process", &Chunk::_process);
     }
 
+	// The ways a chunk can store its blocks
+	enum Storage {
+		OCTREE, // Blocks are stored in the octree
+		PALETTED, // Blocks are stored in a palette compressed array, the octree is rebuilt from it when needed
+		LINEAR // Blocks are stored in a pointerless linear octree, the octree is rebuilt from it when needed
+	};
+
 	static const bool DONT_INTIALIZE = false;
-	Chunk() : VoxelInstance(nullptr) {}
+	Chunk() : VoxelInstance(nullptr) {
+		// All of the chunk's nodes are allocated from its arena
+		arena = &nodeArena;
+	}
+	~Chunk(){
+		// Release all of the nodes at once
+		nodeArena.clear();
+		subVoxels = nullptr;
+	}
 
 	void _init(){}
 
@@ -199,34 +254,160 @@ public:
 		//gout << delta << endl;
 	}
 
-	void initalize(ChunkMap* map){
-		this->map = map;
-		VoxelInstance::init();
-	}
+	void initalize(ChunkMap* map, Storage storage = OCTREE);
 
+	// Function which fills every block in the chunk, <get>(x, y, z) should return the state of each block
+	template<class Getter>
+	void fillBlocks(Getter get);
 	// Implemented so that in the future we may generate chunks on the gpu?
-	void loadFromArray(const std::vector<int>& array){
-		if(!map) throw "Chunk Map not found";
-		iterate(BLOCK_LEVEL, [&array](VoxelInstance* v, int i){
-			int x = v->center.x + CHUNK_DIMENSIONS / 2;
-			int y = v->center.y + CHUNK_DIMENSIONS / 2;
-			int z = v->center.z + CHUNK_DIMENSIONS / 2;
-
-			int index = x * CHUNK_DIMENSIONS * CHUNK_DIMENSIONS + z * CHUNK_DIMENSIONS + y;
-			v->blockData = BlockDatabase::getSingleton()->getBlock(array[index]);
-		});
-		prune();
-	}
+	void loadFromArray(const std::vector<int>& array);
 	void loadFromArray(const std::vector<int>&& array){ loadFromArray(array); }
 
+	// Function which gets which storage backend the chunk is using
+	Storage getStorage() const { return storage; }
+	// Function which converts the chunk to a different storage backend
+	void setStorage(Storage mode);
+	// Functions which get/set the state of the block at the provided chunk-local block coordinates,
+	// setting a block only splits and re-merges the voxels on the path to it
+	BlockState getBlockState(int x, int y, int z);
+	void setBlockState(int x, int y, int z, BlockState state);
+	// Function which places the default state of the block <id> at the provided chunk-local block coordinates
+	void setBlock(int x, int y, int z, Identifier id){ setBlockState(x, y, z, BlockDatabase::getSingleton()->getDefaultState(id)); }
+	// Function which makes sure the octree is up to date with the chunk's storage (only does work in PALETTED and LINEAR mode)
+	void ensureOctree();
+	// Function which frees the octree, it will be rebuilt the next time it is needed (only does work in PALETTED and LINEAR mode)
+	void dropOctree();
+	// Function which creates a pointerless copy of the chunk's blocks (safe to hand to other threads)
+	LinearOctree snapshot();
+	// Function which gets the number of bytes used to store the chunk's blocks
+	size_t memoryUsage() const;
+	// Function which gets the leaf containing the block at the provided chunk-local block coordinates
+	VoxelInstance* getBlock(int x, int y, int z){
+		ensureOctree();
+		return find(BLOCK_LEVEL, ivec3(x, y, z));
+	}
+
+	// Function which gets the position of the chunk in chunk coordinates
+	ivec3 getChunkPosition() const { return chunkPositionOf(center); }
+	// Function which converts the center of a chunk to chunk coordinates
+	static ivec3 chunkPositionOf(const Vector3& center){ return ivec3::floor(center / CHUNK_DIMENSIONS + Vector3(.5, .5, .5)); }
+	// Function which gets the world coordinates of the block at local coordinates (0, 0, 0)
+	ivec3 getCorner() const { return getChunkPosition() * CHUNK_DIMENSIONS - ivec3(CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS / 2); }
+
+	// Function which gets the index of a block in a dense array (x major, y minor)
+	static size_t blockIndex(int x, int y, int z){ return (x * CHUNK_DIMENSIONS + z) * CHUNK_DIMENSIONS + y; }
+	// Function which gets the center of the block at the provided chunk-local block coordinates
+	Vector3 blockCenter(int x, int y, int z) const {
+		return center + Vector3(x - CHUNK_DIMENSIONS / 2 + .5, y - CHUNK_DIMENSIONS / 2 + .5, z - CHUNK_DIMENSIONS / 2 + .5);
+	}
+
 	void recenter(){
 		center = get_translation();
 		VoxelInstance::calculateCenters();
 	}
 
+	// Faces sorted by [Direction][layer], layers are counted from the side the faces point towards
+	typedef std::vector<Face> LayerFaces[6][CHUNK_DIMENSIONS];
+	// Surfaces sorted by [Direction][layer], layers are counted from the side the faces point towards
+	// (wrapped in a struct so that it can be owned through a std::unique_ptr)
+	struct LayerSurfaces {
+		Surface surfaces[6][CHUNK_DIMENSIONS];
+		Surface* operator[](int d){ return surfaces[d]; }
+		const Surface* operator[](int d) const { return surfaces[d]; }
+	};
+	// Function which joins a surface split up by layer back into a single surface
+	static Surface joinLayers(const LayerSurfaces& layers);
+
+	// Variable tracking if vertices shared between faces should be welded together when the chunk is meshed
+	bool weldVertices = true;
+	// Variable tracking if the chunk's mesh should be uploaded with compressed (half float/byte) vertex attributes (only done when the mesher places every vertex on whole coordinates)
+	bool compactVertices = true;
+	// The algorithm which builds the chunk's optimized mesh (nullptr uses the greedy blocky mesher)
+	const Mesher* mesher = nullptr;
+	// Function which picks the mesher the chunk is meshed with at <levelOfDetail> (distant chunks which haven't been edited
+	// are rarely remeshed, so they are meshed with the thorough variant of the chunk's mesher)
+	const Mesher* chooseMesher(int levelOfDetail) const;
+	// Function which queues the chunk to be meshed by the map's workers at <levelOfDetail>
+	// (a quick mesh is shown in the meantime if the chunk doesn't have a mesh yet)
 	void rebuildMesh(int levelOfDetail = 0);
+	// Function which meshes the chunk on the calling thread
 	void buildOptimizedMesh(int levelOfDetail = 0);
+	// Function which sets a mesh built by the map's workers as the chunk's mesh, returns false (and takes nothing) if the chunk
+	// has been queued to be meshed again since the job with the given <generation> was queued
+	// (<wireframe> is the outline of the mesh if the job built one)
+	bool commitMesh(uint64_t generation, int levelOfDetail, std::unique_ptr<LayerSurfaces>& layers, Surface& chunkSpace, Surface* wireframe = nullptr);
+	// Function which gets the octree level the chunk is meshed at
+	int getLevelOfDetail() const { return meshLevelOfDetail; }
+	// Function which sets the octree level the chunk is meshed at without remeshing it (the borders its neighbors capture
+	// are sampled at this level, so a batch of chunks changing level can all be given their new levels before any of them is remeshed)
+	void setLevelOfDetail(int levelOfDetail){ meshLevelOfDetail = levelOfDetail; }
+	// Function which rebuilds a single layer of the optimized mesh (falls back to rebuilding the whole mesh if the mesh isn't split into layers)
+	void remeshLayer(Direction d, int layer);
+	// Function which welds a surface (if enabled), moves it into chunk space, and sets it as the chunk's mesh
+	void setSurface(Surface& surf);
+	// Function which sets a surface which is already in chunk space as the chunk's mesh (and updates the wireframe if one is shown,
+	// using <wireframe> if the outline of the surface has already been built)
+	void showSurface(Surface& chunkSpace, Surface* wireframe = nullptr);
+	// Function which sorts the visible faces of the chunk into the layer they lie in, in a single pass
+	void getLayerFaces(LayerFaces& layers, int levelOfDetail = 0);
+	// Function which greedily meshes the chunk by sorting its faces into layers (the slower reference for BinaryMesher)
+	Surface buildCoplanarSurface(int levelOfDetail = 0);
+	// Function which shows the edges of the chunk's mesh as lines, from then on the wireframe is rebuilt along with the mesh
 	void buildWireframe();
+
+protected:
+	// Arena which owns every node below the root of this chunk
+	VoxelArena nodeArena;
+	// Which backend the blocks are stored in
+	Storage storage = OCTREE;
+	// Palette compressed copy of the blocks (only used in PALETTED mode)
+	PalettedStorage blocks;
+	// Linear octree copy of the blocks (only used in LINEAR mode)
+	LinearOctree linear;
+	// Variable tracking if the octree needs to be rebuilt from the dense storage
+	bool octreeDirty = false;
+	// Variable tracking if a block has been set since the chunk was generated or loaded
+	bool edited = false;
+	// The layers of the optimized mesh, kept so that a single layer can be remeshed (nullptr until the optimized mesh is built)
+	std::unique_ptr<LayerSurfaces> meshLayers;
+	// The level of detail the chunk is meshed at
+	int meshLevelOfDetail = 0;
+	// The generation of the latest mesh job queued for the chunk (0 if the chunk was meshed on the main thread since)
+	uint64_t meshGeneration = 0;
+
+	// Node showing the edges of the mesh (nullptr until a wireframe is requested)
+	MeshInstance* wireframe = nullptr;
+
+	// Function which joins the layers of the optimized mesh and sets them as the chunk's mesh
+	void uploadLayers();
+
+	// Function which copies the blocks in the octree into the dense storage
+	void copyOctreeToDense();
 };
 
+// Function which fills every block in the chunk, <get>(x, y, z) should return the state of each block
+template<class Getter>
+void Chunk::fillBlocks(Getter get){
+	if(storage == PALETTED){
+		for(int x = 0; x < CHUNK_DIMENSIONS; x++)
+			for(int z = 0; z < CHUNK_DIMENSIONS; z++)
+				for(int y = 0; y < CHUNK_DIMENSIONS; y++)
+					blocks.set(blockIndex(x, y, z), get(x, y, z));
+		octreeDirty = true;
+	} else if(storage == LINEAR){
+		// The linear octree is pruned as it is built
+		linear.build(SUBCHUNK_LEVELS, get);
+		octreeDirty = true;
+	} else {
+		// Generate the blocks into a dense array, then build the octree bottom up (pruning as it goes)
+		std::vector<BlockState> dense(CHUNK_ARRAY_SIZE);
+		for(int x = 0; x < CHUNK_DIMENSIONS; x++)
+			for(int z = 0; z < CHUNK_DIMENSIONS; z++)
+				for(int y = 0; y < CHUNK_DIMENSIONS; y++)
+					dense[blockIndex(x, y, z)] = get(x, y, z);
+		build(dense.data());
+		recalculate();
+	}
+}
+
 #endif // CHUNK_H
@@ -1,40 +1,228 @@
 #include "ChunkMap.h"
 #include <OpenSimplexNoise.hpp>
+#include <Viewport.hpp>
+#include <Camera.hpp>
 #include <fstream>
+#include <algorithm>
+#include <cstdlib>
+
+// Unit offsets to the block touching each face (indexed by Direction)
+static const ivec3 directionOffsets[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}, {0, 1, 0}, {0, -1, 0}};
 
 void ChunkMap::_ready(){
-	// Zero out all of the chunks
-	chunk = new Chunk* [CHUNK_MAP_SIZE];
-	for(int i = 0; i < CHUNK_MAP_SIZE; i++) chunk[i] = nullptr;
 	load(Vector3());
 }
 
-void ChunkMap::save(Vector3& position){
-	for(int i = 0; i < CHUNK_MAP_SIZE; i++)
-		if(chunk[i])
-			if(chunk[i]->center == position){
-				std::ofstream os(("world/" + String(chunk[i]->center) + ".chunk.json").utf8().get_data(), std::ios::binary);
-		        oarchive save(os);
-		        save(*chunk[i]);
-				return;
+// Function which sets the material blocks with BlockData::material <index> are drawn with (the loaded chunks are remeshed to use it)
+void ChunkMap::setMaterial(int index, Ref<Material> material){
+	if(index < 0) return;
+	if(index >= (int) materials.size())
+		materials.resize(index + 1);
+	materials[index] = material;
+	// The materials are only applied when a mesh is uploaded
+	chunks.forEach([](const ivec3&, Chunk* c){
+		if(c->get_mesh().is_valid())
+			c->rebuildMesh(c->getLevelOfDetail());
+	});
+}
+
+void ChunkMap::_process(float delta){
+	// Levels of detail are measured from the camera
+	if(Viewport* viewport = get_viewport())
+		if(Camera* camera = viewport->get_camera())
+			viewer = camera->get_global_transform().origin;
+	updateLevelsOfDetail();
+	// Apply the block changes made this frame
+	updateDirty();
+	// Show the meshes which were finished since the last frame
+	commitMeshes();
+}
+
+// Function which sets the meshes the workers have finished as their chunks' meshes (meshes which are out of date are dropped)
+void ChunkMap::commitMeshes(){
+	for(MeshWorkerPool::Result& r: meshWorkers.takeResults()){
+		// The chunk may have been unloaded or queued again while it was being meshed (the result is dropped)
+		if(Chunk* c = getChunk(r.chunk))
+			c->commitMesh(r.generation, r.levelOfDetail, r.layers, r.surface, r.outlined ? &r.wireframe : nullptr);
+	}
+}
+
+// Function which picks the level of detail a chunk should be meshed at from its distance to the viewer
+// (a chunk only changes level once it is LOD_HYSTERESIS past the boundary of its current level)
+int ChunkMap::chooseLevelOfDetail(const Chunk* c) const {
+	int current = c->getLevelOfDetail();
+	// Distance to the chunk in units of LOD_DISTANCE chunks, chunks belong at the level the distance rounds down to
+	float level = (c->center - viewer).length() / (CHUNK_DIMENSIONS * LOD_DISTANCE);
+	if(level >= current - LOD_HYSTERESIS && level < current + 1 + LOD_HYSTERESIS)
+		return current;
+	return std::min(int(level), SUBCHUNK_LEVELS);
+}
+
+// Function which remeshes the chunks whose level of detail changed, and the layers of their neighbors touching them
+void ChunkMap::updateLevelsOfDetail(){
+	// Give every chunk its new level before any of them is remeshed, the snapshots sample the borders of the neighbors
+	// at the levels they are meshed at, so neighbors which change level in the same frame must already be at their new level
+	std::vector<Chunk*> changed;
+	chunks.forEach([this, &changed](const ivec3&, Chunk* c){
+		// Chunks which haven't been meshed yet don't have a level of detail to swap
+		if(c->get_mesh().is_null()) return;
+		int levelOfDetail = chooseLevelOfDetail(c);
+		if(levelOfDetail == c->getLevelOfDetail()) return;
+		c->setLevelOfDetail(levelOfDetail);
+		changed.push_back(c);
+	});
+	for(Chunk* c: changed)
+		c->rebuildMesh(c->getLevelOfDetail());
+
+	// The faces on the borders of the neighbors were culled against the old level of detail
+	for(Chunk* c: changed)
+		for(int d = 0; d < 6; d++){
+			Chunk* neighbor = getChunk(c->getChunkPosition() + directionOffsets[d]);
+			// Neighbors which changed level themselves have already been remeshed
+			if(!neighbor || std::find(changed.begin(), changed.end(), neighbor) != changed.end()) continue;
+			neighbor->remeshLayer(opposite((Direction) d), 0);
+		}
+}
+
+// Function which updates the visibility of the voxels around every dirty block and remeshes the chunks they are in
+void ChunkMap::updateDirty(){
+	if(dirtyBlocks.empty()) return;
+	const ivec3* offsets = directionOffsets;
+
+	// Don't update the same block twice
+	std::sort(dirtyBlocks.begin(), dirtyBlocks.end(), [](const ivec3& a, const ivec3& b){
+		return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+	});
+	dirtyBlocks.erase(std::unique(dirtyBlocks.begin(), dirtyBlocks.end()), dirtyBlocks.end());
+
+	for(const ivec3& block: dirtyBlocks)
+		// Every voxel containing the block may have changed state, so it and the voxels of the same size beside it need updating
+		for(int lvl = SUBCHUNK_LEVELS; lvl >= BLOCK_LEVEL; lvl--){
+			VoxelInstance* v = find(lvl, block);
+			if(!v) break;
+			bool leaf = !v->subVoxels;
+			updateVoxel(v, chunkCoordinate(block));
+			for(int d = 0; d < 6; d++){
+				ivec3 neighbor = block + offsets[d] * (1 << v->level);
+				// Smaller voxels beside a leaf see the leaf as their neighbor, so the neighbor's side facing the leaf needs updating too
+				if(VoxelInstance* n = find(v->level, neighbor))
+					updateVoxel(n, chunkCoordinate(neighbor), leaf ? &offsets[d] : nullptr);
+			}
+			// Once we reach a leaf there is nothing smaller to update
+			if(leaf) break;
+		}
+	// Smooth meshes also depend on the blocks diagonally across the edges and corners of their chunk
+	for(const ivec3& block: dirtyBlocks)
+		for(int x = -1; x <= 1; x++)
+			for(int y = -1; y <= 1; y++)
+				for(int z = -1; z <= 1; z++){
+					ivec3 chunk = chunkCoordinate(block + ivec3(x, y, z));
+					Chunk* c = getChunk(chunk);
+					if(c && c->mesher && c->mesher->readsDiagonals())
+						queueRemesh(chunk);
+				}
+	dirtyBlocks.clear();
+
+	for(const ivec3& position: remeshQueue)
+		if(Chunk* c = getChunk(position))
+			c->rebuildMesh(c->getLevelOfDetail());
+	remeshQueue.clear();
+}
+
+// Function which updates the visibility of a voxel and queues its chunk (at chunk coordinates <chunk>) to be remeshed,
+// if <away> is provided the subVoxels on the side of the voxel facing opposite to it are updated as well
+void ChunkMap::updateVoxel(VoxelInstance* v, const ivec3& chunk, const ivec3* away /*= nullptr*/){
+	v->updateVisibility();
+	if(away && v->subVoxels)
+		for(int i = 0; i < 8; i++){
+			Vector3 offset = v->subVoxels[i].center - v->center;
+			if(offset.x * away->x + offset.y * away->y + offset.z * away->z < 0)
+				updateVoxel(&v->subVoxels[i], chunk, away);
+		}
+
+	queueRemesh(chunk);
+}
+
+// Function which queues the chunk at chunk coordinates <chunk> to be remeshed at the end of the update
+void ChunkMap::queueRemesh(const ivec3& chunk){
+	if(std::find(remeshQueue.begin(), remeshQueue.end(), chunk) == remeshQueue.end())
+		remeshQueue.push_back(chunk);
+}
+
+// Function which updates the visibility of the voxels in <v> touching its side facing direction <d> (all the way down to the leaves)
+void ChunkMap::updateSide(VoxelInstance* v, Direction d){
+	v->updateVisibility();
+	if(!v->subVoxels) return;
+	const ivec3& towards = directionOffsets[d];
+	for(int i = 0; i < 8; i++){
+		Vector3 offset = v->subVoxels[i].center - v->center;
+		if(offset.x * towards.x + offset.y * towards.y + offset.z * towards.z > 0)
+			updateSide(&v->subVoxels[i], d);
+	}
+}
+
+// Function which updates the faces on the borders of the chunks around a newly loaded chunk, only the layer of each
+// neighbor touching the chunk is remeshed (smooth neighbors, including the ones across its edges and corners, are remeshed whole)
+void ChunkMap::stitch(Chunk* c){
+	ivec3 position = c->getChunkPosition();
+	for(int d = 0; d < 6; d++){
+		Chunk* neighbor = getChunk(position + directionOffsets[d]);
+		if(!neighbor) continue;
+		Direction facing = opposite((Direction) d);
+		neighbor->ensureOctree();
+		updateSide(neighbor, facing);
+		// Only the faces pointing at the new chunk from the neighbor's outermost layer can have changed
+		neighbor->remeshLayer(facing, 0);
+	}
+
+	// Smooth meshes also depend on the blocks diagonally across the edges and corners of their chunk
+	for(int x = -1; x <= 1; x++)
+		for(int y = -1; y <= 1; y++)
+			for(int z = -1; z <= 1; z++){
+				// The neighbors across the faces were remeshed above
+				if(std::abs(x) + std::abs(y) + std::abs(z) < 2) continue;
+				Chunk* neighbor = getChunk(position + ivec3(x, y, z));
+				if(neighbor && neighbor->mesher && neighbor->mesher->readsDiagonals() && neighbor->get_mesh().is_valid())
+					neighbor->rebuildMesh(neighbor->getLevelOfDetail());
 			}
 }
 
+void ChunkMap::save(Vector3& position){
+	Chunk* c = chunks.get(Chunk::chunkPositionOf(position));
+	if(!c) return;
+
+	c->ensureOctree();
+	std::ofstream os(("world/" + String(c->center) + ".chunk.json").utf8().get_data(), std::ios::binary);
+	oarchive save(os);
+	save(*c);
+}
+
 void ChunkMap::load(Vector3& position){ 
 	std::ifstream is(("world/" + String(position) + ".chunk.json").utf8().get_data(), std::ios::binary);
-	// TODO: Calculate proper index
-	int i = 1;
+	Chunk* c;
+	// Reading the file leaves the stream at its end, so remember if there was a file
+	bool saved = bool(is);
 	// If the file doesn't exist generate the chunk
-	if(!is){
-		chunk[i] = generateChunk(position);
-		save(position);
-		return;
+	if(!saved)
+		c = generateChunk(position);
+	// If the file does exist load the chunk from the file
+	else {
+		iarchive load(is);
+		c = Chunk::_new();
+		c->map = this;
+		c->mesher = Mesher::get(meshing);
+		load(*c);
+		c->setStorage(storage);
 	}
 
-	// If the file does exist load the chunk from the file
-	iarchive load(is);
-	chunk[i] = Chunk::_new();
-	load(*chunk[i]);
+	// If there was already a chunk at this position... replace it
+	Chunk* old = chunks.insert(c->getChunkPosition(), c);
+	if(old) old->free();
+	// The saved visibility depends on the chunks which were around when it was saved, so it is recalculated against the current ones
+	// (generated chunks are calculated as they are generated)
+	if(saved) c->recalculate();
+	stitch(c);
+	if(!saved) save(position);
 }
 
 
@@ -47,19 +235,12 @@ Chunk* ChunkMap::generateChunk(Vector3& position){
 
 	Chunk* out = Chunk::_new();
 	out->center = position;
-    out->initalize(this);
-    out->iterate(BLOCK_LEVEL, [noise](VoxelInstance* v, int) {
-        //2x + 3y + 5z = 5; y = 5/3 - 2/3x - 5/3z
-        int y = 5.0/3.0 - 2.0 / 3.0 * v->center.z - 5.0/3.0 * v->center.z;
-        if(noise->get_noise_3dv(v->center) > 0)
-        //if (v->center.y < y)
-        //if(v->center.y > 0)
-            v->blockData = BlockDatabase::getSingleton()->getBlock(1);
-        else
-            v->blockData = BlockDatabase::getSingleton()->getBlock(0);
-    });
-    //out->recalculate();
-    out->prune();
-    out->recalculate();
+    out->initalize(this, storage);
+	out->mesher = Mesher::get(meshing);
+	BlockDatabase* db = BlockDatabase::getSingleton();
+	// Sample the noise at the center of each block
+	out->fillBlocks([out, noise, db](int x, int y, int z){
+		return db->getDefaultState(noise->get_noise_3dv(out->blockCenter(x, y, z)) > 0 ? 1 : 0);
+	});
 	return out;
 }
@@ -1,24 +1,43 @@
 #ifndef __CHUNK_MAP_H__
 #define __CHUNK_MAP_H__
 #include "Chunk.h"
+#include "ChunkTable.h"
+#include "../mesh/MeshWorkerPool.h"
+#include "../mesh/Mesher.h"
 #include <Spatial.hpp>
 
 const int LOD_DISTANCE = 1; // The number of chunks before a chunk is reduced to a lower level of detail
+const float LOD_HYSTERESIS = .25; // How far (in units of LOD_DISTANCE) a chunk must move past a level of detail boundary before its level of detail changes
+const int THOROUGH_MESH_LEVEL = 2; // The level of detail from which chunks which haven't been edited are meshed with the thorough variant of their mesher
 const int VIEW_DISTANCE = LOD_DISTANCE * SUBCHUNK_LEVELS; // The number of chunks a player will be able to see
-const int CHUNK_MAP_SIZE = VIEW_DISTANCE * VIEW_DISTANCE * VIEW_DISTANCE * 8;
+const int CHUNK_MAP_SIZE = VIEW_DISTANCE * VIEW_DISTANCE * VIEW_DISTANCE * 8; // The number of chunks the map expects to have loaded at once
 
 class ChunkMap: public Spatial {
     GODOT_CLASS(ChunkMap, Spatial)
 public:
     static void _register_methods(){
 		register_method("_ready", &ChunkMap::_ready);
+		register_method("_process", &ChunkMap::_process);
+		register_method("setMaterial", &ChunkMap::setMaterial);
+		register_method("getMaterial", &ChunkMap::getMaterial);
     }
     void _init() {}
 
-    // Just a single chunk for now TODO: make it an actual chunk map
-    Chunk** chunk = nullptr;
+    // Hash table of the loaded chunks keyed by their chunk coordinates
+    ChunkTable chunks = ChunkTable(CHUNK_MAP_SIZE);
+	// The storage backend used by newly generated or loaded chunks
+	Chunk::Storage storage = Chunk::OCTREE;
+	// The mesher used by newly generated or loaded chunks
+	Mesher::Type meshing = Mesher::BLOCKY;
+	// The materials the chunks are drawn with, indexed by BlockData::material (missing or null materials draw with Godot's default material)
+	std::vector<Ref<Material>> materials;
+	// Function which sets the material blocks with BlockData::material <index> are drawn with (the loaded chunks are remeshed to use it)
+	void setMaterial(int index, Ref<Material> material);
+	// Function which gets the material blocks with BlockData::material <index> are drawn with (null if it hasn't been set)
+	Ref<Material> getMaterial(int index) const { return index >= 0 && index < (int) materials.size() ? materials[index] : Ref<Material>(); }
 
     void _ready();
+	void _process(float delta);
 	Chunk* generateChunk(Vector3& position);
 	Chunk* generateChunk(Vector3&& position) { return generateChunk(position); }
 
@@ -27,15 +46,80 @@ public:
 	void load(Vector3& position);
 	void load(Vector3&& position) { load(position); }
 
-    VoxelInstance* find(int lvl, Vector3& position){
-		//for(int i = 0; i < VIEW_DISTANCE * VIEW_DISTANCE * VIEW_DISTANCE; i++)
-		for(int i = 0; i < CHUNK_MAP_SIZE; i++) // Fix so that I am only looking at one chunk
-			if(chunk[i])
-				if(chunk[i]->within(position))
-					return chunk[i]->find(lvl, position);
-		return nullptr;
-    }
+	// Function which gets the chunk at the provided chunk coordinates (nullptr if it isn't loaded)
+	Chunk* getChunk(const ivec3& chunkPosition){ return chunks.get(chunkPosition); }
+	// Function which gets the chunk coordinates of the chunk containing a block
+	static ivec3 chunkCoordinate(const ivec3& block){
+		return ivec3(floorDiv(block.x + CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS),
+			floorDiv(block.y + CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS),
+			floorDiv(block.z + CHUNK_DIMENSIONS / 2, CHUNK_DIMENSIONS));
+	}
+
+	// Function which finds the voxel of the requested <lvl> containing the block at the provided world block coordinates
+	VoxelInstance* find(int lvl, const ivec3& block){
+		Chunk* c = getChunk(chunkCoordinate(block));
+		if(!c) return nullptr;
+		// Paletted chunks only build their octree when it is needed
+		c->ensureOctree();
+		return c->find(lvl, block - c->getCorner());
+	}
+	// Function which finds the voxel containing the block at the provided world block coordinates at the level of detail its chunk is meshed at
+	VoxelInstance* findDisplayed(const ivec3& block){
+		Chunk* c = getChunk(chunkCoordinate(block));
+		if(!c) return nullptr;
+		c->ensureOctree();
+		return c->find(c->getLevelOfDetail(), block - c->getCorner());
+	}
+	// Function which finds the voxel of the requested <lvl> containing an arbitrary point in space
+	VoxelInstance* find(int lvl, Vector3& position){ return find(lvl, ivec3::floor(position)); }
 	VoxelInstance* find(int lvl, Vector3&& position) { return find(lvl, position); }
+	// Function which gets the leaf containing the block at the provided world block coordinates
+	VoxelInstance* getBlock(int x, int y, int z){ return find(BLOCK_LEVEL, ivec3(x, y, z)); }
+	// Function which sets the state of the block at the provided world block coordinates (nothing happens if its chunk isn't loaded)
+	void setBlockState(const ivec3& block, BlockState state){
+		Chunk* c = getChunk(chunkCoordinate(block));
+		if(!c) return;
+		ivec3 local = block - c->getCorner();
+		c->setBlockState(local.x, local.y, local.z, state);
+	}
+	// Function which places the default state of the block <id> at the provided world block coordinates
+	void setBlock(const ivec3& block, Identifier id){ setBlockState(block, BlockDatabase::getSingleton()->getDefaultState(id)); }
+
+	// Threads which mesh the chunks in the background
+	MeshWorkerPool meshWorkers;
+	// Function which sets the meshes the workers have finished as their chunks' meshes (meshes which are out of date are dropped)
+	void commitMeshes();
+
+	// Position the levels of detail of the chunks are measured from (follows the viewport's camera)
+	Vector3 viewer = {0, 0, 0};
+	// Function which picks the level of detail a chunk should be meshed at from its distance to the viewer
+	// (a chunk only changes level once it is LOD_HYSTERESIS past the boundary of its current level)
+	int chooseLevelOfDetail(const Chunk* c) const;
+	// Function which remeshes the chunks whose level of detail changed, and the layers of their neighbors touching them
+	void updateLevelsOfDetail();
+
+	// Function which marks that the block at the provided world block coordinates changed,
+	// the visibility around it is updated at the end of the frame
+	void markDirty(const ivec3& block){ dirtyBlocks.push_back(block); }
+	// Function which updates the visibility of the voxels around every dirty block and remeshes the chunks they are in
+	void updateDirty();
+
+protected:
+	// World block coordinates of the blocks which have changed since the last update
+	std::vector<ivec3> dirtyBlocks;
+	// Chunk coordinates of the chunks which need to be remeshed
+	std::vector<ivec3> remeshQueue;
+
+	// Function which updates the visibility of a voxel and queues its chunk (at chunk coordinates <chunk>) to be remeshed,
+	// if <away> is provided the subVoxels on the side of the voxel facing opposite to it are updated as well
+	void updateVoxel(VoxelInstance* v, const ivec3& chunk, const ivec3* away = nullptr);
+	// Function which queues the chunk at chunk coordinates <chunk> to be remeshed at the end of the update
+	void queueRemesh(const ivec3& chunk);
+	// Function which updates the visibility of the voxels in <v> touching its side facing direction <d> (all the way down to the leaves)
+	static void updateSide(VoxelInstance* v, Direction d);
+	// Function which updates the faces on the borders of the chunks around a newly loaded chunk, only the layer of each
+	// neighbor touching the chunk is remeshed (smooth neighbors, including the ones across its edges and corners, are remeshed whole)
+	void stitch(Chunk* c);
 };
 
 #endif //__CHUNK_MAP_H__
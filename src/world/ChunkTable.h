@@ -0,0 +1,110 @@
+#ifndef __CHUNK_TABLE_H__
+#define __CHUNK_TABLE_H__
+#include <vector>
+#include <cstdint>
+
+#include "ivec3.h"
+
+class Chunk;
+
+/*
+	Open addressing (linear probing) hash table mapping chunk coordinates to
+	loaded chunks. The table is kept at most half full so finding the chunk
+	which owns a block is a single probe in the common case, no matter how
+	many chunks are loaded.
+*/
+class ChunkTable {
+public:
+	ChunkTable(size_t capacity = 16){ reserve(capacity); }
+
+	// Function which gets the chunk at <position> (nullptr if there isn't one)
+	Chunk* get(const ivec3& position) const {
+		for(size_t i = hash(position) & mask; slots[i].chunk; i = (i + 1) & mask)
+			if(slots[i].position == position)
+				return slots[i].chunk;
+		return nullptr;
+	}
+
+	// Function which adds (or replaces) the chunk at <position>, returns the chunk which was replaced
+	Chunk* insert(const ivec3& position, Chunk* chunk){
+		if((count + 1) * 2 > slots.size())
+			reserve(slots.size());
+
+		size_t i = hash(position) & mask;
+		for(; slots[i].chunk; i = (i + 1) & mask)
+			if(slots[i].position == position){
+				Chunk* old = slots[i].chunk;
+				slots[i].chunk = chunk;
+				return old;
+			}
+		slots[i] = {position, chunk};
+		count++;
+		return nullptr;
+	}
+
+	// Function which removes the chunk at <position>, returns the chunk which was removed
+	Chunk* remove(const ivec3& position){
+		size_t i = hash(position) & mask;
+		for(; slots[i].chunk; i = (i + 1) & mask)
+			if(slots[i].position == position)
+				break;
+		Chunk* out = slots[i].chunk;
+		if(!out) return nullptr;
+
+		// Shift any entries in the same probe run back so no tombstones are needed
+		for(size_t j = (i + 1) & mask; slots[j].chunk; j = (j + 1) & mask){
+			size_t home = hash(slots[j].position) & mask;
+			// If the entry's home slot isn't cyclically within (i, j] it can move into the hole
+			if((j > i && (home <= i || home > j)) || (j < i && (home <= i && home > j))){
+				slots[i] = slots[j];
+				i = j;
+			}
+		}
+		slots[i].chunk = nullptr;
+		count--;
+		return out;
+	}
+
+	// Function which makes sure the table can hold at least <capacity> chunks without growing
+	void reserve(size_t capacity){
+		size_t newSize = 16;
+		while(newSize < capacity * 2) newSize *= 2;
+		if(newSize <= slots.size()) return;
+
+		std::vector<Slot> old(newSize, Slot{ivec3(), nullptr});
+		old.swap(slots);
+		mask = newSize - 1;
+		count = 0;
+		for(Slot& s: old)
+			if(s.chunk)
+				insert(s.position, s.chunk);
+	}
+
+	// Function which runs <func>(position, chunk) for every chunk in the table
+	template<class Function>
+	void forEach(Function func) const {
+		for(const Slot& s: slots)
+			if(s.chunk)
+				func(s.position, s.chunk);
+	}
+
+	size_t size() const { return count; }
+
+protected:
+	struct Slot {
+		ivec3 position;
+		Chunk* chunk; // nullptr marks an empty slot
+	};
+
+	std::vector<Slot> slots;
+	size_t mask = 0;
+	size_t count = 0;
+
+	// Function which mixes the bits of a chunk coordinate
+	static size_t hash(const ivec3& p){
+		uint64_t h = (uint64_t(uint32_t(p.x)) * 0x9E3779B1u) ^ (uint64_t(uint32_t(p.y)) * 0x85EBCA77u) ^ (uint64_t(uint32_t(p.z)) * 0xC2B2AE3Du);
+		return h ^ (h >> 15);
+	}
+};
+
+#endif // __CHUNK_TABLE_H__
@@ -0,0 +1,102 @@
+#include "LinearOctree.h"
+
+// Function which splits a leaf into 8 children with the same state, returns the index of the first child
+uint32_t LinearOctree::split(uint32_t index){
+    uint32_t first = nodes.size();
+    Node child = {nodes[index].state, (unsigned char) (nodes[index].level - 1), nodes[index].flags, 0};
+    nodes.insert(nodes.end(), 8, child);
+    nodes[index].children = first;
+    return first;
+}
+
+// Function which merges the children of a node if they are uniform leaves (otherwise updates the node's state to their mode)
+bool LinearOctree::merge(uint32_t index){
+    const Node* children = &nodes[nodes[index].children];
+
+    // Count how many times each state appears (fixed size, there are only 8 children)
+    BlockState states[8];
+    int counts[8], unique = 0;
+    bool allLeaves = true;
+    for(int c = 0; c < 8; c++){
+        allLeaves &= children[c].isLeaf();
+        int i = 0;
+        while(i < unique && states[i] != children[c].state) i++;
+        if(i == unique){
+            states[unique] = children[c].state;
+            counts[unique++] = 0;
+        }
+        counts[i]++;
+    }
+
+    // The node takes on the most common state of its children
+    int mode = 0;
+    for(int i = 1; i < unique; i++)
+        if(counts[i] > counts[mode])
+            mode = i;
+    nodes[index].state = states[mode];
+
+    // If all of the children are the same leaf... the node can become a leaf
+    // (blocks with unprunable features are only merged at the block level, the same rule as VoxelInstance::merge)
+    if(allLeaves && unique == 1 && (nodes[index].level == 1 || !BlockDatabase::getSingleton()->isUnprunable(states[0]))){
+        nodes[index].children = 0;
+        garbage += 8;
+        return true;
+    }
+    return false;
+}
+
+// Function which sets the state of the block at the provided coordinates, only the path to the block is split and re-merged
+void LinearOctree::set(int x, int y, int z, BlockState state){
+    // Walk down to the block, splitting any leaves along the way
+    uint32_t path[32];
+    int depth = 0;
+    uint32_t i = 0;
+    while(nodes[i].level > 0){
+        if(nodes[i].isLeaf()){
+            if(nodes[i].state == state) return; // The block already has the state
+            split(i);
+        }
+        path[depth++] = i;
+        i = nodes[i].children + childIndex(nodes[i].level, x, y, z);
+    }
+    nodes[i].state = state;
+
+    // Walk back up re-merging the ancestors
+    while(depth)
+        merge(path[--depth]);
+
+    // If too much of the tree is unreachable... compact it
+    if(garbage > nodes.size() / 2)
+        prune();
+}
+
+// Function which removes unreachable nodes and merges any uniform branches, restoring Morton order
+void LinearOctree::prune(){
+    std::vector<Node> out;
+    out.reserve(nodes.size() - garbage);
+    out.push_back(nodes[0]);
+    copyPruned(0, 0, out);
+    nodes.swap(out);
+    garbage = 0;
+}
+
+// Function which copies the branch starting at <index> into <out>, merging uniform branches along the way
+void LinearOctree::copyPruned(uint32_t index, uint32_t to, std::vector<Node>& out) const {
+    if(nodes[index].isLeaf()) return;
+
+    uint32_t first = out.size(), from = nodes[index].children;
+    out.insert(out.end(), nodes.begin() + from, nodes.begin() + from + 8);
+    out[to].children = first;
+    for(int c = 0; c < 8; c++)
+        copyPruned(from + c, first + c, out);
+
+    // If the copied children are all the same leaf... drop them (they are the last nodes in <out>)
+    bool uniform = true;
+    for(int c = 0; c < 8; c++)
+        uniform &= out[first + c].isLeaf() && out[first + c].state == out[first].state;
+    if(uniform && (out[to].level == 1 || !BlockDatabase::getSingleton()->isUnprunable(out[first].state))){
+        out[to].state = out[first].state;
+        out[to].children = 0;
+        out.resize(first);
+    }
+}
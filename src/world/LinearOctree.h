@@ -0,0 +1,159 @@
+#ifndef __LINEAR_OCTREE_H__
+#define __LINEAR_OCTREE_H__
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "../block/BlockDatabase.h"
+
+/*
+	Pointerless octree stored in a single array. The 8 children of a node are
+	stored next to each other in Morton (Z-order) order, and each interior node
+	stores the index of its first child. The tree is built depth first, so a
+	freshly built (or pruned) tree is laid out in Morton order. Since there are
+	no pointers the tree can be copied with memcpy and moved between threads
+	without any fix ups.
+
+	Coordinates are chunk-local block coordinates in the range [0, 2^levels)
+	and the child containing a point is found directly from its coordinate
+	bits: child = xBit | yBit << 1 | zBit << 2.
+*/
+class LinearOctree {
+public:
+	struct Node {
+		// The block state of the node (the most common state of its children for interior nodes)
+		BlockState state;
+		// Which level of the tree the node is on (0 = block level)
+		unsigned char level;
+		// Visibility flags (same layout as VoxelInstance::Flags)
+		unsigned char flags;
+		// Index of the first of the node's 8 children (0 = leaf, the root can never be a child)
+		uint32_t children;
+
+		bool isLeaf() const { return children == 0; }
+
+		template<class Archive>
+		void serialize(Archive& archive){
+			archive(CEREAL_NVP(state), CEREAL_NVP(level), CEREAL_NVP(flags), CEREAL_NVP(children));
+		}
+	};
+	static_assert(std::is_trivially_copyable<Node>::value, "LinearOctree nodes must be trivially copyable");
+
+	// Creates a tree with <levels> levels filled with <fill>
+	LinearOctree(int levels = 0, BlockState fill = 0) { reset(levels, fill); }
+	// Creates a tree from a buffer created with data()
+	LinearOctree(const void* buffer, size_t bytes){
+		nodes.resize(bytes / sizeof(Node));
+		std::memcpy(nodes.data(), buffer, nodes.size() * sizeof(Node));
+	}
+
+	// Function which sets the tree to a single leaf filled with <fill>
+	void reset(int levels, BlockState fill = 0){
+		nodes.assign(1, Node{fill, (unsigned char) levels, 0, 0});
+		garbage = 0;
+	}
+	// Function which builds a pruned tree from a dense array, <get>(x, y, z) should return the state of each block
+	template<class Getter>
+	void build(int levels, Getter get){
+		reset(levels);
+		buildNode(0, 0, 0, 0, get);
+	}
+
+	// Function which finds the index of the node on level <lvl> (or the leaf above it) containing the block
+	uint32_t find(int lvl, int x, int y, int z) const {
+		uint32_t i = 0;
+		while(nodes[i].level > lvl && nodes[i].children)
+			i = nodes[i].children + childIndex(nodes[i].level, x, y, z);
+		return i;
+	}
+	// Function which gets the state of the block at the provided coordinates
+	BlockState get(int x, int y, int z) const { return nodes[find(0, x, y, z)].state; }
+	// Function which sets the state of the block at the provided coordinates, only the path to the block is split and re-merged
+	void set(int x, int y, int z, BlockState state);
+	// Function which removes unreachable nodes and merges any uniform branches, restoring Morton order
+	void prune();
+
+	// Function which runs <func>(node, x, y, z) for every node on level <lvl> (or leaves above it),
+	// (x, y, z) is the minimum corner of the node
+	template<class Function>
+	void iterate(int lvl, Function func) const {
+		struct Entry { uint32_t index; int x, y, z; };
+		Entry stack[8 * 32];
+		int top = 0;
+		stack[top++] = {0, 0, 0, 0};
+		while(top){
+			Entry e = stack[--top];
+			const Node& n = nodes[e.index];
+			if(n.level > lvl && n.children){
+				int half = 1 << (n.level - 1);
+				// Push in reverse so children are visited in Morton order
+				for(int c = 7; c >= 0; c--)
+					stack[top++] = {n.children + c, e.x + (c & 1) * half, e.y + ((c >> 1) & 1) * half, e.z + ((c >> 2) & 1) * half};
+			} else
+				func(n, e.x, e.y, e.z);
+		}
+	}
+
+	// Function which gets the child of a node on level <level> which contains the block
+	static int childIndex(int level, int x, int y, int z){
+		int bit = level - 1;
+		return ((x >> bit) & 1) | (((y >> bit) & 1) << 1) | (((z >> bit) & 1) << 2);
+	}
+
+	// Raw access (for snapshots and save buffers)
+	const Node* data() const { return nodes.data(); }
+	size_t byteSize() const { return nodes.size() * sizeof(Node); }
+	size_t size() const { return nodes.size(); }
+	const Node& operator[](uint32_t i) const { return nodes[i]; }
+	Node& operator[](uint32_t i) { return nodes[i]; }
+	// Function which gets the number of bytes used by the tree
+	size_t memoryUsage() const { return sizeof(*this) + nodes.capacity() * sizeof(Node); }
+
+	// Serialization
+	template<class Archive>
+	void serialize(Archive& archive){
+		archive(CEREAL_NVP(nodes));
+		garbage = 0;
+	}
+
+	// Nodes in the tree (nodes[0] is the root)
+	std::vector<Node> nodes;
+
+protected:
+	// The number of nodes which are no longer reachable (left behind when branches merge)
+	size_t garbage = 0;
+
+	// Function which splits a leaf into 8 children with the same state, returns the index of the first child
+	uint32_t split(uint32_t index);
+	// Function which merges the children of a node if they are uniform leaves (otherwise updates the node's state to their mode)
+	bool merge(uint32_t index);
+	// Function which copies the branch starting at <index> into <out>, merging uniform branches along the way
+	void copyPruned(uint32_t index, uint32_t to, std::vector<Node>& out) const;
+
+	// Function which recursively fills in the node at <index> from a dense array, returns true if the node is a leaf
+	template<class Getter>
+	bool buildNode(uint32_t index, int x, int y, int z, Getter& get){
+		int level = nodes[index].level;
+		if(level == 0){
+			nodes[index].state = get(x, y, z);
+			return true;
+		}
+
+		// Create the children and fill them in
+		uint32_t first = split(index);
+		int half = 1 << (level - 1);
+		for(int c = 0; c < 8; c++)
+			buildNode(first + c, x + (c & 1) * half, y + ((c >> 1) & 1) * half, z + ((c >> 2) & 1) * half, get);
+
+		// If the children are all the same leaf... collapse them (they are the last nodes in the array)
+		if(merge(index)){
+			nodes.resize(first);
+			garbage -= 8;
+			return true;
+		}
+		return false;
+	}
+};
+
+#endif // __LINEAR_OCTREE_H__
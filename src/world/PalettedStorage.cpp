@@ -0,0 +1,54 @@
+#include "PalettedStorage.h"
+
+const unsigned short PalettedStorage::NOT_FOUND;
+
+// Function which resizes the storage and sets every voxel to <fill>
+void PalettedStorage::reset(size_t size, BlockState fill){
+    voxels = size;
+    bits = 1;
+    mask = 1;
+    palette.clear();
+    lookup.clear();
+    data.assign((voxels * bits + 63) / 64, 0);
+    // Palette index 0 is the fill state
+    addToPalette(fill);
+}
+
+// Function which adds a state to the palette (growing the bit width if needed)
+unsigned short PalettedStorage::addToPalette(BlockState state){
+    // If the palette can no longer be indexed with the current width... double it
+    if(palette.size() >= (size_t(1) << bits))
+        repack(bits * 2);
+
+    if(state >= lookup.size())
+        lookup.resize(state + 1, NOT_FOUND);
+    lookup[state] = palette.size();
+    palette.push_back(state);
+    return lookup[state];
+}
+
+// Function which repacks the data using <newBits> bits per voxel
+void PalettedStorage::repack(int newBits){
+    std::vector<uint64_t> packed((voxels * newBits + 63) / 64, 0);
+    uint64_t newMask = newBits == 64 ? ~uint64_t(0) : (uint64_t(1) << newBits) - 1;
+    for(size_t i = 0; i < voxels; i++){
+        size_t bit = i * bits, newBit = i * newBits;
+        packed[newBit >> 6] |= ((data[bit >> 6] >> (bit & 63)) & mask) << (newBit & 63);
+    }
+    data.swap(packed);
+    bits = newBits;
+    mask = newMask;
+}
+
+// Function which removes palette entries which are no longer used (may shrink the bit width)
+void PalettedStorage::compact(){
+    // Read back every voxel, then rebuild the storage using only the states which appear
+    std::vector<BlockState> states(voxels);
+    for(size_t i = 0; i < voxels; i++)
+        states[i] = get(i);
+
+    reset(voxels, voxels ? states[0] : 0);
+    for(size_t i = 0; i < voxels; i++)
+        set(i, states[i]);
+    data.shrink_to_fit();
+}
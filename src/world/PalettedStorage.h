@@ -0,0 +1,79 @@
+#ifndef __PALETTED_STORAGE_H__
+#define __PALETTED_STORAGE_H__
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "../block/BlockDatabase.h"
+
+/*
+	Dense array of block states compressed with a local palette. Every voxel
+	stores a 1, 2, 4, 8, or 16 bit index into the palette, the width grows
+	(and the array is repacked) when the palette outgrows it. Entries never
+	straddle two words since every width divides 64.
+*/
+class PalettedStorage {
+public:
+	// Creates storage for <size> voxels all set to <fill>
+	PalettedStorage(size_t size = 0, BlockState fill = 0) { reset(size, fill); }
+
+	// Function which resizes the storage and sets every voxel to <fill>
+	void reset(size_t size, BlockState fill = 0);
+
+	// Function which gets the state of the voxel at <index>
+	BlockState get(size_t index) const {
+		size_t bit = index * bits;
+		return palette[(data[bit >> 6] >> (bit & 63)) & mask];
+	}
+	// Function which sets the state of the voxel at <index>
+	void set(size_t index, BlockState state){
+		// Adding the state to the palette may repack the data, so the index has to be found before the word is located
+		uint64_t entry = paletteIndex(state);
+		size_t bit = index * bits;
+		uint64_t& word = data[bit >> 6];
+		word = (word & ~(mask << (bit & 63))) | (entry << (bit & 63));
+	}
+
+	// Function which removes palette entries which are no longer used (may shrink the bit width)
+	void compact();
+
+	// Function which gets the number of voxels in the storage
+	size_t size() const { return voxels; }
+	// Function which gets the number of bits used per voxel
+	int getBitsPerVoxel() const { return bits; }
+	// Function which gets the palette of states used by the storage
+	const std::vector<BlockState>& getPalette() const { return palette; }
+	// Function which gets the number of bytes used by the storage
+	size_t memoryUsage() const {
+		return sizeof(*this) + data.capacity() * sizeof(uint64_t) + palette.capacity() * sizeof(BlockState)
+			+ lookup.capacity() * sizeof(unsigned short);
+	}
+
+protected:
+	// Function which finds (or adds) the palette index of a state
+	unsigned short paletteIndex(BlockState state){
+		if(state < lookup.size() && lookup[state] != NOT_FOUND)
+			return lookup[state];
+		return addToPalette(state);
+	}
+	// Function which adds a state to the palette (growing the bit width if needed)
+	unsigned short addToPalette(BlockState state);
+	// Function which repacks the data using <newBits> bits per voxel
+	void repack(int newBits);
+
+	static const unsigned short NOT_FOUND = 0xFFFF;
+
+	// The number of voxels stored
+	size_t voxels = 0;
+	// The number of bits used to store each voxel and a mask with that many bits set
+	int bits = 1;
+	uint64_t mask = 1;
+	// Bit packed palette indices
+	std::vector<uint64_t> data;
+	// Local palette mapping indices to block states
+	std::vector<BlockState> palette;
+	// Reverse of the palette, maps block states to their local index
+	std::vector<unsigned short> lookup;
+};
+
+#endif // __PALETTED_STORAGE_H__
@@ -0,0 +1,61 @@
+#include "VoxelArena.h"
+
+#include <new>
+
+#include "Chunk.h"
+
+// Function which gets a block of 8 empty sub voxels
+VoxelInstance* VoxelArena::allocate(){
+    VoxelInstance* out;
+    // Reuse a released block if there is one
+    if(freeList.size()){
+        out = freeList.back();
+        freeList.pop_back();
+    } else {
+        // If the current slab is full... create a new one
+        if(used == BLOCKS_PER_SLAB){
+            VoxelInstance* slab = static_cast<VoxelInstance*>(::operator new(sizeof(VoxelInstance) * 8 * BLOCKS_PER_SLAB));
+            for(size_t i = 0; i < 8 * BLOCKS_PER_SLAB; i++)
+                new (slab + i) VoxelInstance(nullptr);
+            slabs.push_back(slab);
+            used = 0;
+        }
+        out = slabs.back() + 8 * used++;
+    }
+
+    // Mark the arena as the owner of the new nodes
+    for(int i = 0; i < 8; i++)
+        out[i].arena = this;
+    live++;
+    return out;
+}
+
+// Function which returns a block of 8 sub voxels (and all of their children) to the arena
+void VoxelArena::release(VoxelInstance* block){
+    for(int i = 0; i < 8; i++){
+        if(block[i].subVoxels) release(block[i].subVoxels);
+        block[i].subVoxels = nullptr;
+        // Reset the node so that it is ready to be handed out again
+        block[i].blockState = 0;
+        block[i].flags = VoxelInstance::null;
+    }
+    freeList.push_back(block);
+    live--;
+}
+
+// Function which destroys every node in the arena and frees all of the slabs at once
+void VoxelArena::clear(){
+    // Arena owned nodes don't own any memory of their own, so the slabs can be dropped without
+    // running the destructor of each node
+    for(VoxelInstance* slab: slabs)
+        ::operator delete(slab);
+    slabs.clear();
+    freeList.clear();
+    used = BLOCKS_PER_SLAB;
+    live = 0;
+}
+
+// Function which gets the number of bytes reserved by the arena
+size_t VoxelArena::capacity() const {
+    return slabs.size() * 8 * BLOCKS_PER_SLAB * sizeof(VoxelInstance);
+}
@@ -0,0 +1,50 @@
+#ifndef __VOXEL_ARENA_H__
+#define __VOXEL_ARENA_H__
+#include <vector>
+#include <cstddef>
+
+class VoxelInstance;
+
+/*
+	Slab allocator which owns all of the subVoxel storage for a single chunk.
+	Storage is handed out in blocks of 8 VoxelInstances (one octree level) and
+	blocks which are released get pushed onto a free list to be reused by the
+	next split, so pruning and unpruning no longer touch the heap. Every node
+	lives in one of a handful of contiguous slabs which are all freed at once
+	when the owning chunk is unloaded.
+*/
+class VoxelArena {
+public:
+	// The number of 8 node blocks stored in each slab (a fully expanded 16^3 chunk needs 585 blocks)
+	static const size_t BLOCKS_PER_SLAB = 64;
+
+	VoxelArena() {}
+	~VoxelArena(){ clear(); }
+	// The arena hands out raw pointers into its slabs, so it can't be copied
+	VoxelArena(const VoxelArena&) = delete;
+	VoxelArena& operator=(const VoxelArena&) = delete;
+
+	// Function which gets a block of 8 empty sub voxels
+	VoxelInstance* allocate();
+	// Function which returns a block of 8 sub voxels (and all of their children) to the arena
+	void release(VoxelInstance* block);
+	// Function which destroys every node in the arena and frees all of the slabs at once
+	void clear();
+
+	// Function which gets the number of blocks currently handed out
+	size_t liveBlocks() const { return live; }
+	// Function which gets the number of bytes reserved by the arena
+	size_t capacity() const;
+
+private:
+	// Slabs of BLOCKS_PER_SLAB * 8 constructed VoxelInstances
+	std::vector<VoxelInstance*> slabs;
+	// Blocks which have been released and can be handed out again
+	std::vector<VoxelInstance*> freeList;
+	// The number of blocks which have been handed out from the most recent slab
+	size_t used = BLOCKS_PER_SLAB;
+	// The number of blocks currently handed out
+	size_t live = 0;
+};
+
+#endif // __VOXEL_ARENA_H__
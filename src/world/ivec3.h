@@ -0,0 +1,26 @@
+#ifndef __IVEC3_H__
+#define __IVEC3_H__
+#include <cmath>
+
+#include <Vector3.hpp>
+
+// Integer vector used for block and chunk coordinates
+struct ivec3 {
+	int x, y, z;
+
+	ivec3(int x = 0, int y = 0, int z = 0) : x(x), y(y), z(z) {}
+	// Function which gets the integer coordinates of the block containing a point
+	static ivec3 floor(const godot::Vector3& v){ return ivec3(std::floor(v.x), std::floor(v.y), std::floor(v.z)); }
+
+	ivec3 operator+(const ivec3& o) const { return ivec3(x + o.x, y + o.y, z + o.z); }
+	ivec3 operator-(const ivec3& o) const { return ivec3(x - o.x, y - o.y, z - o.z); }
+	ivec3 operator*(int s) const { return ivec3(x * s, y * s, z * s); }
+	bool operator==(const ivec3& o) const { return x == o.x && y == o.y && z == o.z; }
+	bool operator!=(const ivec3& o) const { return !(*this == o); }
+	operator godot::Vector3() const { return godot::Vector3(x, y, z); }
+};
+
+// Function which divides rounding towards negative infinity (so negative coordinates map to the correct chunk)
+inline int floorDiv(int a, int b){ return (a >= 0 ? a : a - b + 1) / b; }
+
+#endif // __IVEC3_H__